@@ -40,6 +40,9 @@ void PendSV_Handler(void);
 void SysTick_Handler(void);
 
 void SPI1_IRQHandler(void);
+void FLASH_IRQHandler(void);
+void DMA1_Channel1_IRQHandler(void);
+void DMA1_Channel2_IRQHandler(void);
 
 #ifdef __cplusplus
 }
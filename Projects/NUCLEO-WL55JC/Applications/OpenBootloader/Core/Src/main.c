@@ -134,6 +134,7 @@ void System_DeInit(void)
   SPIx_DeInit();
   HAL_RCC_DeInit();
   HAL_NVIC_DisableIRQ(SPIx_IRQn);
+  HAL_NVIC_DisableIRQ(FLASH_IRQn);
 }
 
 /**
@@ -48,4 +48,73 @@ void HAL_MspDeInit(void)
 {
 }
 
+/**
+  * @brief  Initializes the CRC MSP.
+  * @param  hcrc CRC handle pointer
+  * @retval None
+  */
+void HAL_CRC_MspInit(CRC_HandleTypeDef *hcrc)
+{
+  __HAL_RCC_CRC_CLK_ENABLE();
+}
+
+/**
+  * @brief  De-Initializes the CRC MSP.
+  * @param  hcrc CRC handle pointer
+  * @retval None
+  */
+void HAL_CRC_MspDeInit(CRC_HandleTypeDef *hcrc)
+{
+  __HAL_RCC_CRC_FORCE_RESET();
+  __HAL_RCC_CRC_RELEASE_RESET();
+
+  __HAL_RCC_CRC_CLK_DISABLE();
+}
+
+/**
+  * @brief  Initializes the CRYP MSP.
+  * @param  hcryp CRYP handle pointer
+  * @retval None
+  */
+void HAL_CRYP_MspInit(CRYP_HandleTypeDef *hcryp)
+{
+  __HAL_RCC_AES_CLK_ENABLE();
+}
+
+/**
+  * @brief  De-Initializes the CRYP MSP.
+  * @param  hcryp CRYP handle pointer
+  * @retval None
+  */
+void HAL_CRYP_MspDeInit(CRYP_HandleTypeDef *hcryp)
+{
+  __HAL_RCC_AES_FORCE_RESET();
+  __HAL_RCC_AES_RELEASE_RESET();
+
+  __HAL_RCC_AES_CLK_DISABLE();
+}
+
+/**
+  * @brief  Initializes the PKA MSP.
+  * @param  hpka PKA handle pointer
+  * @retval None
+  */
+void HAL_PKA_MspInit(PKA_HandleTypeDef *hpka)
+{
+  __HAL_RCC_PKA_CLK_ENABLE();
+}
+
+/**
+  * @brief  De-Initializes the PKA MSP.
+  * @param  hpka PKA handle pointer
+  * @retval None
+  */
+void HAL_PKA_MspDeInit(PKA_HandleTypeDef *hpka)
+{
+  __HAL_RCC_PKA_FORCE_RESET();
+  __HAL_RCC_PKA_RELEASE_RESET();
+
+  __HAL_RCC_PKA_CLK_DISABLE();
+}
+
 
@@ -22,6 +22,8 @@
 #include "main.h"
 #include "stm32wlxx_it.h"
 #include "spi_interface.h"
+#include "flash_interface.h"
+#include "cryp_interface.h"
 
 /* Private includes ----------------------------------------------------------*/
 /* Private typedef -----------------------------------------------------------*/
@@ -41,8 +43,12 @@
   */
 void NMI_Handler(void)
 {
-  while (1)
+  /* A FLASH ECC double error found by the ECC scan is recorded and the scan goes on */
+  if (OPENBL_FLASH_NMIHandler() != SUCCESS)
   {
+    while (1)
+    {
+    }
   }
 }
 
@@ -130,3 +136,26 @@ void SPI1_IRQHandler(void)
   OPENBL_SPI_IRQHandler();
 }
 
+/**
+ * @brief This function handles FLASH global interrupt.
+ */
+void FLASH_IRQHandler(void)
+{
+  OPENBL_FLASH_IRQHandler();
+}
+
+/**
+ * @brief This function handles DMA1 Channel 1 interrupt, AES input.
+ */
+void DMA1_Channel1_IRQHandler(void)
+{
+  OPENBL_CRYP_DMAInIRQHandler();
+}
+
+/**
+ * @brief This function handles DMA1 Channel 2 interrupt, AES output.
+ */
+void DMA1_Channel2_IRQHandler(void)
+{
+  OPENBL_CRYP_DMAOutIRQHandler();
+}
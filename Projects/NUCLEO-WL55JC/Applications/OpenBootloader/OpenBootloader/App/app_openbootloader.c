@@ -30,6 +30,7 @@
 #include "engibytes_interface.h"
 
 #include "iwdg_interface.h"
+#include "program_interface.h"
 
 #include "openbl_usart_cmd.h"
 #include "openbl_spi_cmd.h"
@@ -79,12 +80,30 @@ static OPENBL_OpsTypeDef IWDG_Ops =
 /* Exported variables --------------------------------------------------------*/
 uint16_t SpecialCmdList[SPECIAL_CMD_MAX_NUMBER] =
 {
-  SPECIAL_CMD_DEFAULT
+  SPECIAL_CMD_DEFAULT,
+  SPECIAL_CMD_ERASE_ON_WRITE,
+  SPECIAL_CMD_PAGE_DIGEST,
+  SPECIAL_CMD_CRC,
+  SPECIAL_CMD_FLASH_FLUSH,
+  SPECIAL_CMD_ERASE_STATUS,
+  SPECIAL_CMD_RANGE_ERASE,
+  SPECIAL_CMD_SLOT,
+  SPECIAL_CMD_JOURNAL,
+  SPECIAL_CMD_WEAR,
+  SPECIAL_CMD_ECC_SCAN,
+  SPECIAL_CMD_SIGNATURE,
+  SPECIAL_CMD_DIGEST,
+  SPECIAL_CMD_POOL_STATS,
+  SPECIAL_CMD_OTP_STATUS
 };
 
 uint16_t ExtendedSpecialCmdList[EXTENDED_SPECIAL_CMD_MAX_NUMBER] =
 {
-  SPECIAL_CMD_DEFAULT
+  SPECIAL_CMD_DEFAULT,
+  SPECIAL_CMD_COMPRESSED_WRITE,
+  SPECIAL_CMD_ENCRYPTED_WRITE,
+  SPECIAL_CMD_SEGMENT_WRITE,
+  SPECIAL_CMD_RAM_LOADER
 };
 
 /* External variables --------------------------------------------------------*/
@@ -121,13 +140,16 @@ void OpenBootloader_Init(void)
   /* Initialize interfaces */
   OPENBL_Init();
 
-  /* Initialize memories */
-  OPENBL_MEM_RegisterMemory(&FLASH_Descriptor);
-  OPENBL_MEM_RegisterMemory(&RAM_Descriptor);
-  OPENBL_MEM_RegisterMemory(&ICP1_Descriptor);
-  OPENBL_MEM_RegisterMemory(&OB1_Descriptor);
-  OPENBL_MEM_RegisterMemory(&OTP_Descriptor);
-  OPENBL_MEM_RegisterMemory(&EB_Descriptor);
+  /* Initialize memories, the descriptors are constant and only read by the middleware */
+  OPENBL_MEM_RegisterMemory((OPENBL_MemoryTypeDef *)&FLASH_Descriptor);
+  OPENBL_MEM_RegisterMemory((OPENBL_MemoryTypeDef *)&RAM_Descriptor);
+  OPENBL_MEM_RegisterMemory((OPENBL_MemoryTypeDef *)&ICP1_Descriptor);
+  OPENBL_MEM_RegisterMemory((OPENBL_MemoryTypeDef *)&OB1_Descriptor);
+  OPENBL_MEM_RegisterMemory((OPENBL_MemoryTypeDef *)&OTP_Descriptor);
+  OPENBL_MEM_RegisterMemory((OPENBL_MemoryTypeDef *)&EB_Descriptor);
+
+  /* Initialize the FLASH programming engine */
+  OPENBL_PROG_Init();
 }
 
 /**
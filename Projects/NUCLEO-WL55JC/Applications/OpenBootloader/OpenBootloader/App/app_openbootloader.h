@@ -30,9 +30,27 @@ extern "C" {
 
 /* Exported types ------------------------------------------------------------*/
 /* Exported constants --------------------------------------------------------*/
-#define SPECIAL_CMD_MAX_NUMBER            0x01U  /* Special command max length array */
-#define EXTENDED_SPECIAL_CMD_MAX_NUMBER   0x01U  /* Extended special command max length array */
+#define SPECIAL_CMD_MAX_NUMBER            0x0FU  /* Special command max length array */
+#define EXTENDED_SPECIAL_CMD_MAX_NUMBER   0x05U  /* Extended special command max length array */
 #define SPECIAL_CMD_DEFAULT               0x0102U  /* Default special command */
+#define SPECIAL_CMD_ERASE_ON_WRITE        0x0103U  /* Enable or disable the FLASH erase on first write mode */
+#define SPECIAL_CMD_PAGE_DIGEST           0x0104U  /* Get the digest of FLASH pages */
+#define SPECIAL_CMD_CRC                   0x0105U  /* Get the CRC-32 of a memory range */
+#define SPECIAL_CMD_FLASH_FLUSH           0x0106U  /* Program the cached partial FLASH double word */
+#define SPECIAL_CMD_ERASE_STATUS          0x0107U  /* Get the progress of the FLASH erase operations */
+#define SPECIAL_CMD_RANGE_ERASE           0x0108U  /* Erase the FLASH pages of address ranges */
+#define SPECIAL_CMD_SLOT                  0x0109U  /* Get the A/B slot status or switch the active slot */
+#define SPECIAL_CMD_JOURNAL               0x010AU  /* Record the verified pages of a download, get the resume point */
+#define SPECIAL_CMD_WEAR                  0x010BU  /* Get the erase counters of the FLASH pages */
+#define SPECIAL_CMD_ECC_SCAN              0x010CU  /* Get the ECC errors of a FLASH range */
+#define SPECIAL_CMD_COMPRESSED_WRITE      0x010DU  /* Write LZSS compressed data in FLASH (extended command) */
+#define SPECIAL_CMD_ENCRYPTED_WRITE       0x010EU  /* Write AES-128 CTR encrypted data in FLASH (extended command) */
+#define SPECIAL_CMD_SIGNATURE             0x010FU  /* Verify the ECDSA signature of an image */
+#define SPECIAL_CMD_DIGEST                0x0110U  /* Get the SHA-256 digest of a memory range */
+#define SPECIAL_CMD_SEGMENT_WRITE         0x0111U  /* Write a list of memory segments (extended command) */
+#define SPECIAL_CMD_RAM_LOADER            0x0112U  /* Call a loader written in RAM (extended command) */
+#define SPECIAL_CMD_POOL_STATS            0x0113U  /* Get the statistics of the SRAM2 buffer pool */
+#define SPECIAL_CMD_OTP_STATUS            0x0114U  /* Get the result of the OTP writes */
 
 /* Exported macro ------------------------------------------------------------*/
 /* Exported functions ------------------------------------------------------- */
@@ -41,12 +59,12 @@ void OpenBootloader_DeInit(void);
 void OpenBootloader_ProtocolDetection(void);
 
 /* External variables --------------------------------------------------------*/
-extern OPENBL_MemoryTypeDef FLASH_Descriptor;
-extern OPENBL_MemoryTypeDef RAM_Descriptor;
-extern OPENBL_MemoryTypeDef ICP1_Descriptor;
-extern OPENBL_MemoryTypeDef OB1_Descriptor;
-extern OPENBL_MemoryTypeDef OTP_Descriptor;
-extern OPENBL_MemoryTypeDef EB_Descriptor;
+extern const OPENBL_MemoryTypeDef FLASH_Descriptor;
+extern const OPENBL_MemoryTypeDef RAM_Descriptor;
+extern const OPENBL_MemoryTypeDef ICP1_Descriptor;
+extern const OPENBL_MemoryTypeDef OB1_Descriptor;
+extern const OPENBL_MemoryTypeDef OTP_Descriptor;
+extern const OPENBL_MemoryTypeDef EB_Descriptor;
 
 extern uint16_t SpecialCmdList[SPECIAL_CMD_MAX_NUMBER];
 extern uint16_t ExtendedSpecialCmdList[EXTENDED_SPECIAL_CMD_MAX_NUMBER];
@@ -20,14 +20,41 @@
 #include "platform.h"
 #include "flash_interface.h"
 #include "openbootloader_conf.h"
+#include "openbl_core.h"
+#include "app_openbootloader.h"
 #include "common_interface.h"
+#include "otp_interface.h"
+#include "usart_interface.h"
+#include "spi_interface.h"
 
 /* Private typedef -----------------------------------------------------------*/
+/* Address range of a memory registered by OpenBootloader_Init() */
+typedef struct
+{
+  uint32_t StartAddress;
+  uint32_t EndAddress;
+  const OPENBL_MemoryTypeDef *pMemory;
+} Common_MemoryRegionTypeDef;
+
 /* Private define ------------------------------------------------------------*/
+#define COMMON_MEMORY_REGIONS             (sizeof(MemoryMap) / sizeof(MemoryMap[0]))
+
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 static Function_Pointer ResetCallback;
 
+/* Memory map in FLASH, sorted by start address. The ranges are the compile time constants of the
+   descriptors, so that a lookup does not read the descriptors */
+static const Common_MemoryRegionTypeDef MemoryMap[] =
+{
+  {FLASH_START_ADDRESS,    FLASH_END_ADDRESS, &FLASH_Descriptor},
+  {ICP1_START_ADDRESS,     ICP1_END_ADDRESS,  &ICP1_Descriptor},
+  {OTP_START_ADDRESS,      OTP_END_ADDRESS,   &OTP_Descriptor},
+  {EB_START_ADDRESS,       EB_END_ADDRESS,    &EB_Descriptor},
+  {OB1_START_ADDRESS,      OB1_END_ADDRESS,   &OB1_Descriptor},
+  {RAM_USER_START_ADDRESS, RAM_END_ADDRESS,   &RAM_Descriptor}
+};
+
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
 /* Exported functions --------------------------------------------------------*/
@@ -60,6 +87,31 @@ void Common_DisableIrq(void)
   __disable_irq();
 }
 
+/**
+  * @brief  Disable IRQ Interrupts and return the previous interrupt mask.
+  * @note   Unlike Common_DisableIrq(), the critical sections can be nested, the interrupts are only
+  *         enabled again by Common_RestoreIrq() if they were enabled on entry.
+  * @retval The PRIMASK value to be given to Common_RestoreIrq().
+  */
+uint32_t Common_SaveDisableIrq(void)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+
+  return primask;
+}
+
+/**
+  * @brief  Restore the interrupt mask saved by Common_SaveDisableIrq().
+  * @param  PriMask The PRIMASK value returned by Common_SaveDisableIrq().
+  * @retval None.
+  */
+void Common_RestoreIrq(uint32_t PriMask)
+{
+  __set_PRIMASK(PriMask);
+}
+
 /**
   * @brief  Checks whether the target Protection Status is set or not.
   * @retval Returns SET if protection is enabled else return RESET.
@@ -103,3 +155,146 @@ void Common_StartPostProcessing()
     ResetCallback = NULL;
   }
 }
+
+/**
+  * @brief  Get a 32-bit value sent MSB first by the host.
+  * @param  pBuffer Pointer to the first byte of the value.
+  * @retval Returns the 32-bit value.
+  */
+uint32_t Common_GetWord(uint8_t *pBuffer)
+{
+  return (((uint32_t)pBuffer[0] << 24U) | ((uint32_t)pBuffer[1] << 16U)
+          | ((uint32_t)pBuffer[2] << 8U) | (uint32_t)pBuffer[3]);
+}
+
+/**
+  * @brief  Send a 16-bit value MSB first to the host.
+  * @param  SendByte The function used to send one byte through the detected interface.
+  * @param  HalfWord The value to be sent.
+  * @retval None.
+  */
+void Common_SendHalfWord(Send_Byte_Func *SendByte, uint16_t HalfWord)
+{
+  SendByte((uint8_t)(HalfWord >> 8U));
+  SendByte((uint8_t)(HalfWord & 0xFFU));
+}
+
+/**
+  * @brief  Send a 32-bit value MSB first to the host.
+  * @param  SendByte The function used to send one byte through the detected interface.
+  * @param  Word The value to be sent.
+  * @retval None.
+  */
+void Common_SendWord(Send_Byte_Func *SendByte, uint32_t Word)
+{
+  Common_SendHalfWord(SendByte, (uint16_t)(Word >> 16U));
+  Common_SendHalfWord(SendByte, (uint16_t)(Word & 0xFFFFU));
+}
+
+/**
+  * @brief  Send the status part of a special command response, one ACK or NACK byte.
+  * @param  SendByte The function used to send one byte through the detected interface.
+  * @param  Status The status of the special command.
+  * @retval None.
+  */
+void Common_SendSpecialCmdStatus(Send_Byte_Func *SendByte, ErrorStatus Status)
+{
+  /* Status size */
+  Common_SendHalfWord(SendByte, 1U);
+
+  SendByte((Status == SUCCESS) ? ACK_BYTE : NACK_BYTE);
+}
+
+/**
+  * @brief  Send a NACK byte through the detected interface.
+  * @note   Used when a jump is refused, the Go command has already acknowledged the address.
+  * @retval None.
+  */
+void Common_SendNack(void)
+{
+  if (OPENBL_USART_IsDetected() != 0U)
+  {
+    OPENBL_USART_SendByte(NACK_BYTE);
+  }
+  else if (OPENBL_SPI_IsDetected() != 0U)
+  {
+    OPENBL_SPI_SendAcknowledgeByte(NACK_BYTE);
+  }
+  else
+  {
+    /* No interface detected */
+  }
+}
+
+/**
+  * @brief  Get the memory that contains an address range.
+  * @note   Binary search of the last memory starting at or below the address, then check of its end.
+  * @param  Address The start address of the range.
+  * @param  Length The length of the range in bytes.
+  * @retval Returns the memory descriptor, or NULL if the range is not fully inside one memory.
+  */
+const OPENBL_MemoryTypeDef *Common_GetMemory(uint32_t Address, uint32_t Length)
+{
+  uint32_t low  = 0U;
+  uint32_t high = COMMON_MEMORY_REGIONS;
+  uint32_t middle;
+  const OPENBL_MemoryTypeDef *p_memory = NULL;
+
+  /* Number of memories starting at or below the address */
+  while (low < high)
+  {
+    middle = (low + high) / 2U;
+
+    if (MemoryMap[middle].StartAddress <= Address)
+    {
+      low = middle + 1U;
+    }
+    else
+    {
+      high = middle;
+    }
+  }
+
+  if ((low != 0U) && (Address < MemoryMap[low - 1U].EndAddress)
+      && (Length <= (MemoryMap[low - 1U].EndAddress - Address)))
+  {
+    p_memory = MemoryMap[low - 1U].pMemory;
+  }
+
+  return p_memory;
+}
+
+/**
+  * @brief  Read a block of a memory.
+  * @note   The memories that are mapped are read in place, without one call of the Read callback per
+  *         byte. The FLASH and the OTP area are read in place unless the block contains bytes that their
+  *         Read callback returns differently, the block is then copied in the buffer.
+  * @param  pMemory Pointer to the memory descriptor of the block.
+  * @param  Address The address of the block, the block must be inside the memory.
+  * @param  pBuffer Pointer to the buffer used when the block can not be read in place.
+  * @param  BufferSize The size of the buffer in bytes.
+  * @param  pLength Pointer to the length of the block, updated with the number of bytes returned. It is
+  *         only reduced to the size of the buffer when the block is copied.
+  * @retval Returns a pointer to the bytes of the block.
+  */
+const uint8_t *Common_ReadBlock(const OPENBL_MemoryTypeDef *pMemory, uint32_t Address, uint8_t *pBuffer,
+                                uint32_t BufferSize, uint32_t *pLength)
+{
+  const uint8_t *p_data;
+
+  if (pMemory->Type == FLASH_AREA)
+  {
+    p_data = OPENBL_FLASH_ReadBlock(Address, pBuffer, BufferSize, pLength);
+  }
+  else if (pMemory->Type == OTP_AREA)
+  {
+    p_data = OPENBL_OTP_ReadBlock(Address, pBuffer, BufferSize, pLength);
+  }
+  else
+  {
+    /* RAM, system memory, option bytes and engineering bytes are read as they are mapped */
+    p_data = (const uint8_t *)Address;
+  }
+
+  return p_data;
+}
@@ -25,9 +25,12 @@ extern "C" {
 #endif
 
 /* Includes ------------------------------------------------------------------*/
+#include "openbl_mem.h"
+
 /* Exported types ------------------------------------------------------------*/
 typedef void (*Function_Pointer)(void);
 typedef void (Send_BusyByte_Func)(void);
+typedef void (Send_Byte_Func)(uint8_t Byte);
 
 /* Exported constants --------------------------------------------------------*/
 /* Exported macro ------------------------------------------------------------*/
@@ -35,9 +38,19 @@ typedef void (Send_BusyByte_Func)(void);
 void Common_SetMsp(uint32_t TopOfMainStack);
 void Common_EnableIrq(void);
 void Common_DisableIrq(void);
+uint32_t Common_SaveDisableIrq(void);
+void Common_RestoreIrq(uint32_t PriMask);
 FlagStatus Common_GetProtectionStatus(void);
 void Common_SetPostProcessingCallback(Function_Pointer Callback);
 void Common_StartPostProcessing(void);
+uint32_t Common_GetWord(uint8_t *pBuffer);
+void Common_SendHalfWord(Send_Byte_Func *SendByte, uint16_t HalfWord);
+void Common_SendWord(Send_Byte_Func *SendByte, uint32_t Word);
+void Common_SendSpecialCmdStatus(Send_Byte_Func *SendByte, ErrorStatus Status);
+void Common_SendNack(void);
+const OPENBL_MemoryTypeDef *Common_GetMemory(uint32_t Address, uint32_t Length);
+const uint8_t *Common_ReadBlock(const OPENBL_MemoryTypeDef *pMemory, uint32_t Address, uint8_t *pBuffer,
+                                uint32_t BufferSize, uint32_t *pLength);
 
 #ifdef __cplusplus
 }
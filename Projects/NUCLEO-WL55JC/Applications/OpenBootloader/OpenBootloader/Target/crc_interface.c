@@ -0,0 +1,301 @@
+/**
+  ******************************************************************************
+  * @file    crc_interface.c
+  * @author  MCD Application Team
+  * @brief   Contains CRC computation functions
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "platform.h"
+#include "openbl_core.h"
+#include "app_openbootloader.h"
+#include "common_interface.h"
+#include "crc_interface.h"
+#include "flash_interface.h"
+#include "iwdg_interface.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+#define CRC_CHUNK_SIZE                    (4U * 1024U)  /* Bytes computed between two watchdog refreshes */
+#define CRC_FINAL_XOR_VALUE               0xFFFFFFFFU
+#define CRC_DMA_TIMEOUT                   100U          /* Timeout of the transfer of one chunk in ms */
+#define CRC_BUFFER_SIZE                   256U          /* Bytes copied at once from a memory not mapped */
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static CRC_HandleTypeDef CrcHandle;
+static DMA_HandleTypeDef CrcDmaHandle;
+
+/* Word aligned, as it is read by DMA */
+static uint32_t CrcBuffer[CRC_BUFFER_SIZE / 4U];
+
+/* Private function prototypes -----------------------------------------------*/
+static void OPENBL_CRC_Init(void);
+static uint32_t OPENBL_CRC_DeInit(void);
+static void OPENBL_CRC_Accumulate(uint32_t Address, uint32_t Length);
+static void OPENBL_CRC_AccumulateByte(uint8_t Byte);
+static void OPENBL_CRC_AccumulateWords(uint32_t Address, uint32_t Length);
+
+/* Exported variables --------------------------------------------------------*/
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Compute the CRC-32 of a memory range with the CRC peripheral.
+  * @note   The result is the standard CRC-32 (polynomial 0x04C11DB7, reflected input and output,
+  *         initial value and final XOR 0xFFFFFFFF), the one given by zlib crc32().
+  * @param  Address The start address of the range.
+  * @param  Length The length of the range in bytes.
+  * @retval Returns the CRC-32 of the range.
+  */
+uint32_t OPENBL_CRC_Calculate(uint32_t Address, uint32_t Length)
+{
+  uint32_t chunk;
+
+  OPENBL_CRC_Init();
+
+  while (Length > 0U)
+  {
+    OPENBL_IWDG_Refresh();
+
+    chunk = (Length > CRC_CHUNK_SIZE) ? CRC_CHUNK_SIZE : Length;
+
+    OPENBL_CRC_Accumulate(Address, chunk);
+
+    Address += chunk;
+    Length  -= chunk;
+  }
+
+  return OPENBL_CRC_DeInit();
+}
+
+/**
+  * @brief  Compute the CRC-32 of a range of a registered memory.
+  * @note   The range is read in place when its memory is mapped, otherwise it is copied through the
+  *         Read callback of its memory, so that the bytes hidden by the callback are not taken into
+  *         account.
+  * @param  pMemory Pointer to the memory descriptor of the range.
+  * @param  Address The start address of the range.
+  * @param  Length The length of the range in bytes.
+  * @retval Returns the CRC-32 of the range.
+  */
+uint32_t OPENBL_CRC_CalculateMemory(const OPENBL_MemoryTypeDef *pMemory, uint32_t Address, uint32_t Length)
+{
+  uint32_t chunk;
+  const uint8_t *p_data;
+
+  OPENBL_CRC_Init();
+
+  while (Length > 0U)
+  {
+    OPENBL_IWDG_Refresh();
+
+    chunk  = (Length > CRC_CHUNK_SIZE) ? CRC_CHUNK_SIZE : Length;
+    p_data = Common_ReadBlock(pMemory, Address, (uint8_t *)CrcBuffer, sizeof(CrcBuffer), &chunk);
+
+    OPENBL_CRC_Accumulate((uint32_t)p_data, chunk);
+
+    Address += chunk;
+    Length  -= chunk;
+  }
+
+  return OPENBL_CRC_DeInit();
+}
+
+/**
+  * @brief  This function is used to process the CRC special command.
+  *         Buffer1 contains the start address and the length of a range of any memory, 4 bytes each MSB
+  *         first. The response data is the CRC-32 of the range, MSB first. The status is NACK if the range
+  *         is not inside one memory, if the read protection is active, the CRC of short ranges would give
+  *         the memory content, or if a FLASH programming error occurred since the previous CRC command, so
+  *         that the host verifies a download without reading it back.
+  * @param  SpecialCmd Pointer to the OPENBL_SpecialCmdTypeDef structure.
+  * @param  SendByte The function used to send one byte through the detected interface.
+  * @retval None.
+  */
+void OPENBL_CRC_Command(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte)
+{
+  uint32_t address;
+  uint32_t length;
+  uint32_t crc                  = 0U;
+  const OPENBL_MemoryTypeDef *p_memory = NULL;
+  ErrorStatus status             = ERROR;
+
+  if ((SpecialCmd->SizeBuffer1 == 8U) && (Common_GetProtectionStatus() == RESET))
+  {
+    address  = Common_GetWord(&SpecialCmd->Buffer1[0]);
+    length   = Common_GetWord(&SpecialCmd->Buffer1[4]);
+    p_memory = Common_GetMemory(address, length);
+
+    if ((length != 0U) && (p_memory != NULL))
+    {
+      if (p_memory->Type == FLASH_AREA)
+      {
+        /* The range must be fully programmed and its pages must not be waiting to be erased */
+        OPENBL_FLASH_FlushWriteCache();
+        OPENBL_FLASH_WaitForPendingErase();
+      }
+
+      crc    = OPENBL_CRC_CalculateMemory(p_memory, address, length);
+      status = SUCCESS;
+    }
+  }
+
+  /* Report the programming errors of the previous write operations */
+  if (OPENBL_FLASH_GetWriteStatus() != SUCCESS)
+  {
+    status = ERROR;
+  }
+
+  if (SpecialCmd->CmdType == OPENBL_SPECIAL_CMD)
+  {
+    if (status == SUCCESS)
+    {
+      Common_SendHalfWord(SendByte, 4U);
+      Common_SendWord(SendByte, crc);
+    }
+    else
+    {
+      /* Send NULL data size */
+      Common_SendHalfWord(SendByte, 0U);
+    }
+  }
+
+  Common_SendSpecialCmdStatus(SendByte, status);
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Configure the CRC peripheral for a standard CRC-32 and its memory to memory DMA channel.
+  * @retval None.
+  */
+static void OPENBL_CRC_Init(void)
+{
+  CrcHandle.Instance                     = CRC;
+  CrcHandle.Init.DefaultPolynomialUse    = DEFAULT_POLYNOMIAL_ENABLE;
+  CrcHandle.Init.DefaultInitValueUse     = DEFAULT_INIT_VALUE_ENABLE;
+  CrcHandle.Init.InputDataInversionMode  = CRC_INPUTDATA_INVERSION_BYTE;
+  CrcHandle.Init.OutputDataInversionMode = CRC_OUTPUTDATA_INVERSION_ENABLE;
+  CrcHandle.InputDataFormat              = CRC_INPUTDATA_FORMAT_BYTES;
+
+  __HAL_RCC_DMAMUX1_CLK_ENABLE();
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  /* The source is the peripheral side of a memory to memory transfer, the CRC data register
+     is the fixed destination */
+  CrcDmaHandle.Instance                 = DMA1_Channel3;
+  CrcDmaHandle.Init.Request             = DMA_REQUEST_MEM2MEM;
+  CrcDmaHandle.Init.Direction           = DMA_MEMORY_TO_MEMORY;
+  CrcDmaHandle.Init.PeriphInc           = DMA_PINC_ENABLE;
+  CrcDmaHandle.Init.MemInc              = DMA_MINC_DISABLE;
+  CrcDmaHandle.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+  CrcDmaHandle.Init.MemDataAlignment    = DMA_MDATAALIGN_WORD;
+  CrcDmaHandle.Init.Mode                = DMA_NORMAL;
+  CrcDmaHandle.Init.Priority            = DMA_PRIORITY_HIGH;
+
+  if ((HAL_CRC_Init(&CrcHandle) != HAL_OK) || (HAL_DMA_Init(&CrcDmaHandle) != HAL_OK))
+  {
+    Error_Handler();
+  }
+
+  __HAL_CRC_DR_RESET(&CrcHandle);
+}
+
+/**
+  * @brief  Release the CRC peripheral and its DMA channel.
+  * @retval Returns the CRC-32 of the bytes fed since the configuration.
+  */
+static uint32_t OPENBL_CRC_DeInit(void)
+{
+  uint32_t crc = CrcHandle.Instance->DR;
+
+  (void)HAL_DMA_DeInit(&CrcDmaHandle);
+  (void)HAL_CRC_DeInit(&CrcHandle);
+
+  __HAL_RCC_DMA1_CLK_DISABLE();
+  __HAL_RCC_DMAMUX1_CLK_DISABLE();
+
+  return (crc ^ CRC_FINAL_XOR_VALUE);
+}
+
+/**
+  * @brief  Feed a range to the CRC peripheral.
+  * @note   The 32-bit words of the range are fed by DMA, the unaligned bytes at both ends of the range
+  *         are fed one by one.
+  * @param  Address The start address of the range.
+  * @param  Length The length of the range in bytes.
+  * @retval None.
+  */
+static void OPENBL_CRC_Accumulate(uint32_t Address, uint32_t Length)
+{
+  uint32_t words_length;
+
+  while (((Address & 0x3U) != 0U) && (Length > 0U))
+  {
+    OPENBL_CRC_AccumulateByte(*(uint8_t *)Address);
+
+    Address++;
+    Length--;
+  }
+
+  words_length = Length & ~0x3U;
+
+  if (words_length != 0U)
+  {
+    OPENBL_CRC_AccumulateWords(Address, words_length);
+
+    Address += words_length;
+    Length  -= words_length;
+  }
+
+  while (Length > 0U)
+  {
+    OPENBL_CRC_AccumulateByte(*(uint8_t *)Address);
+
+    Address++;
+    Length--;
+  }
+}
+
+/**
+  * @brief  Feed one byte to the CRC peripheral.
+  * @note   The bit reversal is done byte per byte for 8-bit writes of the data register.
+  * @param  Byte The byte.
+  * @retval None.
+  */
+static void OPENBL_CRC_AccumulateByte(uint8_t Byte)
+{
+  (void)HAL_CRCEx_Input_Data_Reverse(&CrcHandle, CRC_INPUTDATA_INVERSION_BYTE);
+
+  *(__IO uint8_t *)(__IO void *)(&CrcHandle.Instance->DR) = Byte;
+}
+
+/**
+  * @brief  Feed the 32-bit words of an aligned range to the CRC peripheral by DMA.
+  * @note   A little endian word holds its first byte in its least significant bits, the bit reversal
+  *         of the whole word makes the CRC peripheral process the bytes in memory order.
+  * @param  Address The start address of the range, word aligned.
+  * @param  Length The length of the range in bytes, a multiple of 4.
+  * @retval None.
+  */
+static void OPENBL_CRC_AccumulateWords(uint32_t Address, uint32_t Length)
+{
+  (void)HAL_CRCEx_Input_Data_Reverse(&CrcHandle, CRC_INPUTDATA_INVERSION_WORD);
+
+  if ((HAL_DMA_Start(&CrcDmaHandle, Address, (uint32_t)&CrcHandle.Instance->DR, Length / 4U) != HAL_OK)
+      || (HAL_DMA_PollForTransfer(&CrcDmaHandle, HAL_DMA_FULL_TRANSFER, CRC_DMA_TIMEOUT) != HAL_OK))
+  {
+    Error_Handler();
+  }
+}
@@ -0,0 +1,386 @@
+/**
+  ******************************************************************************
+  * @file    cryp_interface.c
+  * @author  MCD Application Team
+  * @brief   Contains AES decryption functions used by the encrypted write
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "platform.h"
+#include "openbl_core.h"
+#include "app_openbootloader.h"
+#include "common_interface.h"
+#include "cryp_interface.h"
+#include "flash_interface.h"
+#include "pool_interface.h"
+#include "iwdg_interface.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* State of the encrypted stream, kept between two encrypted write commands */
+typedef struct
+{
+  uint32_t Address;      /* FLASH address of the next decrypted byte */
+  uint32_t Counter[4];   /* Counter block of the next AES block, MSB first words */
+  uint8_t  Started;      /* A stream is started and no error occurred */
+  uint8_t  LastBlock;    /* A partial AES block is received, it ends the ciphertext */
+} CRYP_StreamTypeDef;
+
+/* Private define ------------------------------------------------------------*/
+#define CRYP_CMD_START                    0x00U  /* Start a stream at the given address with the given IV */
+#define CRYP_CMD_CONTINUE                 0x01U  /* Decrypt the next bytes of the stream */
+#define CRYP_CMD_END                      0x02U  /* End the stream and program its last bytes */
+
+#define CRYP_BLOCK_SIZE                   16U   /* Size of an AES block */
+#define CRYP_KEY_SIZE                     16U   /* Size of the AES-128 key */
+#define CRYP_CHUNK_SIZE                   256U  /* Bytes decrypted by one DMA transfer */
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static CRYP_HandleTypeDef CrypHandle;
+static DMA_HandleTypeDef CrypDmaInHandle;
+static DMA_HandleTypeDef CrypDmaOutHandle;
+static CRYP_StreamTypeDef CrypStream = {0U};
+
+/* Private function prototypes -----------------------------------------------*/
+static ErrorStatus OPENBL_CRYP_Decrypt(uint8_t *pData, uint32_t Length);
+static ErrorStatus OPENBL_CRYP_Init(uint32_t *pKey);
+static void OPENBL_CRYP_DeInit(void);
+static uint32_t OPENBL_CRYP_StartChunk(uint32_t *pBuffer, uint8_t *pData, uint32_t Length);
+
+/* Exported variables --------------------------------------------------------*/
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  This function is used to process the encrypted write extended special command.
+  *         Buffer1 is 0x00 followed by the FLASH address (4 bytes MSB first) and the initial counter block
+  *         (16 bytes) to start a stream, 0x01 to continue it or 0x02 to end it. Buffer2 contains the next
+  *         AES-128 CTR ciphertext bytes of the stream, a multiple of 16 bytes except for the last ones.
+  *         The plaintext is written in FLASH as it is decrypted. The status is NACK if the stream is not
+  *         valid or if no key is programmed, and at the end of the stream if a FLASH programming error
+  *         occurred.
+  * @param  SpecialCmd Pointer to the OPENBL_SpecialCmdTypeDef structure.
+  * @param  SendByte The function used to send one byte through the detected interface.
+  * @retval None.
+  */
+void OPENBL_CRYP_WriteCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte)
+{
+  uint32_t index;
+  uint32_t address;
+  ErrorStatus status = ERROR;
+
+  if (Common_GetProtectionStatus() != RESET)
+  {
+    CrypStream.Started = 0U;
+  }
+  else if ((SpecialCmd->SizeBuffer1 == 21U) && (SpecialCmd->Buffer1[0] == CRYP_CMD_START))
+  {
+    address = Common_GetWord(&SpecialCmd->Buffer1[1]);
+
+    if ((address >= FLASH_START_ADDRESS) && (address < FLASH_END_ADDRESS))
+    {
+      CrypStream.Address = address;
+
+      for (index = 0U; index < 4U; index++)
+      {
+        CrypStream.Counter[index] = Common_GetWord(&SpecialCmd->Buffer1[5U + (index * 4U)]);
+      }
+
+      CrypStream.LastBlock = 0U;
+      CrypStream.Started   = 1U;
+
+      status = SUCCESS;
+    }
+  }
+  else if ((SpecialCmd->SizeBuffer1 == 1U) && (SpecialCmd->Buffer1[0] == CRYP_CMD_CONTINUE))
+  {
+    status = (CrypStream.Started != 0U) ? SUCCESS : ERROR;
+  }
+  else if ((SpecialCmd->SizeBuffer1 == 1U) && (SpecialCmd->Buffer1[0] == CRYP_CMD_END))
+  {
+    status = (CrypStream.Started != 0U) ? SUCCESS : ERROR;
+
+    CrypStream.Started = 0U;
+  }
+  else
+  {
+    /* Unknown operation */
+  }
+
+  if ((status == SUCCESS) && (SpecialCmd->SizeBuffer2 != 0U))
+  {
+    /* Only the last ciphertext bytes may not fill an AES block */
+    if ((CrypStream.LastBlock != 0U)
+        || ((FLASH_END_ADDRESS - CrypStream.Address) < SpecialCmd->SizeBuffer2))
+    {
+      status = ERROR;
+    }
+    else
+    {
+      status = OPENBL_CRYP_Decrypt(SpecialCmd->Buffer2, SpecialCmd->SizeBuffer2);
+    }
+  }
+
+  if (status == SUCCESS)
+  {
+    if (SpecialCmd->Buffer1[0] == CRYP_CMD_END)
+    {
+      OPENBL_FLASH_FlushWriteCache();
+
+      status = OPENBL_FLASH_GetWriteStatus();
+    }
+  }
+  else
+  {
+    /* The counter of a broken stream is lost */
+    CrypStream.Started = 0U;
+  }
+
+  Common_SendSpecialCmdStatus(SendByte, status);
+}
+
+/**
+  * @brief  This function handles the DMA interrupt of the AES input.
+  * @retval None.
+  */
+void OPENBL_CRYP_DMAInIRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&CrypDmaInHandle);
+}
+
+/**
+  * @brief  This function handles the DMA interrupt of the AES output.
+  * @retval None.
+  */
+void OPENBL_CRYP_DMAOutIRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&CrypDmaOutHandle);
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Decrypt the next ciphertext bytes of the stream and write them in FLASH.
+  * @note   The ciphertext is decrypted by DMA in chunks of 256 bytes, the next chunk is decrypted
+  *         while the previous one is programmed. The two chunk buffers are in a block borrowed from
+  *         the pool, which is word aligned as needed by the DMA.
+  * @param  pData Pointer to the ciphertext bytes.
+  * @param  Length The number of ciphertext bytes.
+  * @retval An ErrorStatus enumeration value:
+  *          - SUCCESS: The bytes are decrypted and given to the FLASH interface
+  *          - ERROR:   No key is programmed, no pool block is available or the AES peripheral failed
+  */
+static ErrorStatus OPENBL_CRYP_Decrypt(uint8_t *pData, uint32_t Length)
+{
+  uint32_t index;
+  uint32_t current = 0U;
+  uint32_t length;
+  uint32_t next_length;
+  uint32_t key[CRYP_KEY_SIZE / 4U];
+  uint32_t key_blank = 1U;
+  uint32_t *p_buffers[2];
+  uint8_t *p_block   = OPENBL_POOL_Get();
+  ErrorStatus status;
+
+  /* The key is stored MSB first in the last bytes of the OTP area */
+  for (index = 0U; index < (CRYP_KEY_SIZE / 4U); index++)
+  {
+    key[index] = Common_GetWord((uint8_t *)(CRYP_KEY_ADDRESS + (index * 4U)));
+
+    if (key[index] != 0xFFFFFFFFU)
+    {
+      key_blank = 0U;
+    }
+  }
+
+  status = ((key_blank == 0U) && (p_block != NULL)) ? OPENBL_CRYP_Init(key) : ERROR;
+
+  if (status == SUCCESS)
+  {
+    p_buffers[0] = (uint32_t *)(uint32_t)p_block;
+    p_buffers[1] = (uint32_t *)(uint32_t)&p_block[CRYP_CHUNK_SIZE];
+
+    length = OPENBL_CRYP_StartChunk(p_buffers[current], pData, Length);
+    pData  += length;
+    Length -= length;
+
+    while (length != 0U)
+    {
+      while (HAL_CRYP_GetState(&CrypHandle) != HAL_CRYP_STATE_READY)
+      {
+        OPENBL_IWDG_Refresh();
+      }
+
+      if (HAL_CRYP_GetError(&CrypHandle) != HAL_CRYP_ERROR_NONE)
+      {
+        status = ERROR;
+        break;
+      }
+
+      /* Start the next chunk before programming the decrypted one */
+      next_length = OPENBL_CRYP_StartChunk(p_buffers[current ^ 1U], pData, Length);
+      pData  += next_length;
+      Length -= next_length;
+
+      OPENBL_FLASH_Write(CrypStream.Address, (uint8_t *)p_buffers[current], length);
+
+      CrypStream.Address += length;
+
+      /* The AES peripheral increments the last word of the counter block */
+      CrypStream.Counter[3] += (length + CRYP_BLOCK_SIZE - 1U) / CRYP_BLOCK_SIZE;
+
+      if ((length % CRYP_BLOCK_SIZE) != 0U)
+      {
+        CrypStream.LastBlock = 1U;
+      }
+
+      length  = next_length;
+      current ^= 1U;
+    }
+
+    /* A chunk could not be started */
+    if (Length != 0U)
+    {
+      status = ERROR;
+    }
+
+    OPENBL_CRYP_DeInit();
+  }
+
+  OPENBL_POOL_Release(p_block);
+
+  /* Do not leave the key on the stack */
+  for (index = 0U; index < (CRYP_KEY_SIZE / 4U); index++)
+  {
+    key[index] = 0U;
+  }
+
+  return status;
+}
+
+/**
+  * @brief  Configure the AES peripheral in CTR mode and its DMA channels.
+  * @note   The counter block is loaded with the first decryption only, so the chunks of a command
+  *         follow each other.
+  * @param  pKey Pointer to the AES-128 key, MSB first words.
+  * @retval An ErrorStatus enumeration value:
+  *          - SUCCESS: The AES peripheral is configured
+  *          - ERROR:   The AES peripheral or its DMA channels are not configured
+  */
+static ErrorStatus OPENBL_CRYP_Init(uint32_t *pKey)
+{
+  ErrorStatus status = SUCCESS;
+
+  __HAL_RCC_DMAMUX1_CLK_ENABLE();
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  CrypDmaInHandle.Instance                 = DMA1_Channel1;
+  CrypDmaInHandle.Init.Request             = DMA_REQUEST_AES_IN;
+  CrypDmaInHandle.Init.Direction           = DMA_MEMORY_TO_PERIPH;
+  CrypDmaInHandle.Init.PeriphInc           = DMA_PINC_DISABLE;
+  CrypDmaInHandle.Init.MemInc              = DMA_MINC_ENABLE;
+  CrypDmaInHandle.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+  CrypDmaInHandle.Init.MemDataAlignment    = DMA_MDATAALIGN_WORD;
+  CrypDmaInHandle.Init.Mode                = DMA_NORMAL;
+  CrypDmaInHandle.Init.Priority            = DMA_PRIORITY_HIGH;
+
+  CrypDmaOutHandle.Instance                 = DMA1_Channel2;
+  CrypDmaOutHandle.Init.Request             = DMA_REQUEST_AES_OUT;
+  CrypDmaOutHandle.Init.Direction           = DMA_PERIPH_TO_MEMORY;
+  CrypDmaOutHandle.Init.PeriphInc           = DMA_PINC_DISABLE;
+  CrypDmaOutHandle.Init.MemInc              = DMA_MINC_ENABLE;
+  CrypDmaOutHandle.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+  CrypDmaOutHandle.Init.MemDataAlignment    = DMA_MDATAALIGN_WORD;
+  CrypDmaOutHandle.Init.Mode                = DMA_NORMAL;
+  CrypDmaOutHandle.Init.Priority            = DMA_PRIORITY_VERY_HIGH;
+
+  if ((HAL_DMA_Init(&CrypDmaInHandle) != HAL_OK) || (HAL_DMA_Init(&CrypDmaOutHandle) != HAL_OK))
+  {
+    status = ERROR;
+  }
+  else
+  {
+    __HAL_LINKDMA(&CrypHandle, hdmain, CrypDmaInHandle);
+    __HAL_LINKDMA(&CrypHandle, hdmaout, CrypDmaOutHandle);
+
+    HAL_NVIC_SetPriority(DMA1_Channel1_IRQn, 2U, 0U);
+    HAL_NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+    HAL_NVIC_SetPriority(DMA1_Channel2_IRQn, 2U, 0U);
+    HAL_NVIC_EnableIRQ(DMA1_Channel2_IRQn);
+
+    CrypHandle.Instance             = AES;
+    CrypHandle.Init.DataType        = CRYP_DATATYPE_8B;
+    CrypHandle.Init.KeySize         = CRYP_KEYSIZE_128B;
+    CrypHandle.Init.pKey            = pKey;
+    CrypHandle.Init.pInitVect       = CrypStream.Counter;
+    CrypHandle.Init.Algorithm       = CRYP_AES_CTR;
+    CrypHandle.Init.DataWidthUnit   = CRYP_DATAWIDTHUNIT_BYTE;
+    CrypHandle.Init.KeyIVConfigSkip = CRYP_KEYIVCONFIG_ONCE;
+
+    if (HAL_CRYP_Init(&CrypHandle) != HAL_OK)
+    {
+      OPENBL_CRYP_DeInit();
+
+      status = ERROR;
+    }
+  }
+
+  return status;
+}
+
+/**
+  * @brief  Reset the AES peripheral and release its DMA channels.
+  * @retval None.
+  */
+static void OPENBL_CRYP_DeInit(void)
+{
+  HAL_NVIC_DisableIRQ(DMA1_Channel1_IRQn);
+  HAL_NVIC_DisableIRQ(DMA1_Channel2_IRQn);
+
+  (void)HAL_CRYP_DeInit(&CrypHandle);
+  (void)HAL_DMA_DeInit(&CrypDmaInHandle);
+  (void)HAL_DMA_DeInit(&CrypDmaOutHandle);
+
+  __HAL_RCC_DMA1_CLK_DISABLE();
+  __HAL_RCC_DMAMUX1_CLK_DISABLE();
+}
+
+/**
+  * @brief  Copy the next ciphertext chunk in a DMA buffer and start its decryption.
+  * @note   A chunk that does not fill its last AES block is padded with zeros, the padding is
+  *         decrypted but not programmed.
+  * @param  pBuffer Pointer to the DMA buffer, the plaintext replaces the ciphertext.
+  * @param  pData Pointer to the ciphertext bytes.
+  * @param  Length The number of ciphertext bytes left.
+  * @retval Returns the number of ciphertext bytes of the chunk, 0 if no byte is left or if the
+  *         decryption could not be started, the bytes are then left to the caller.
+  */
+static uint32_t OPENBL_CRYP_StartChunk(uint32_t *pBuffer, uint8_t *pData, uint32_t Length)
+{
+  uint32_t index;
+  uint32_t length = (Length > CRYP_CHUNK_SIZE) ? CRYP_CHUNK_SIZE : Length;
+  uint32_t padded_length = ((length + CRYP_BLOCK_SIZE - 1U) / CRYP_BLOCK_SIZE) * CRYP_BLOCK_SIZE;
+  uint8_t *p_buffer = (uint8_t *)pBuffer;
+
+  for (index = 0U; index < padded_length; index++)
+  {
+    p_buffer[index] = (index < length) ? pData[index] : 0x00U;
+  }
+
+  if ((length != 0U) && (HAL_CRYP_Decrypt_DMA(&CrypHandle, pBuffer, (uint16_t)padded_length, pBuffer) != HAL_OK))
+  {
+    length = 0U;
+  }
+
+  return length;
+}
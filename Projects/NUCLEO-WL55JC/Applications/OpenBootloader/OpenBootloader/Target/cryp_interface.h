@@ -0,0 +1,43 @@
+/**
+  ******************************************************************************
+  * @file    cryp_interface.h
+  * @author  MCD Application Team
+  * @brief   Header for cryp_interface.c module
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef CRYP_INTERFACE_H
+#define CRYP_INTERFACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "openbl_core.h"
+#include "common_interface.h"
+
+/* Exported types ------------------------------------------------------------*/
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+void OPENBL_CRYP_WriteCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte);
+void OPENBL_CRYP_DMAInIRQHandler(void);
+void OPENBL_CRYP_DMAOutIRQHandler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CRYP_INTERFACE_H */
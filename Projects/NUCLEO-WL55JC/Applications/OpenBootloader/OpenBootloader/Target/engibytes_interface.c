@@ -29,7 +29,7 @@
 /* Private variables ---------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
 /* Exported variables --------------------------------------------------------*/
-OPENBL_MemoryTypeDef EB_Descriptor =
+const OPENBL_MemoryTypeDef EB_Descriptor =
 {
   EB_START_ADDRESS,
   EB_END_ADDRESS,
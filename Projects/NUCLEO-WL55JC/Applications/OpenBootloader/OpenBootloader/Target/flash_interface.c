@@ -23,23 +23,151 @@
 #include "common_interface.h"
 #include "flash_interface.h"
 #include "optionbytes_interface.h"
+#include "iwdg_interface.h"
+#include "crc_interface.h"
+#include "program_interface.h"
+#include "signature_interface.h"
 
 /* Private typedef -----------------------------------------------------------*/
+/* Download journal read from the journal records */
+typedef struct
+{
+  uint32_t PageAddress;                         /* Journal page of the current download, 0 if there is none */
+  uint32_t FreeAddress;                         /* Next record address, 0 if the journal page is full */
+  uint32_t Sequence;                            /* Sequence number of the current download */
+  uint32_t ImageId;                             /* Image identifier given by the host */
+  uint32_t FirstPage;                           /* First FLASH page of the download */
+  uint32_t PagesNumber;                         /* Number of FLASH pages of the download */
+  uint32_t DonePages[128U / 32U];               /* FLASH pages programmed and verified */
+} FLASH_JournalTypeDef;
+
 /* Private define ------------------------------------------------------------*/
 #define FLASH_PAGE_MAX_NUMBER             ((uint8_t)0x7FU)
 #define FLASH_PROG_STEP_SIZE              ((uint8_t)0x8U)
 #define FLASH_PAGE_NUMBER                 ((uint16_t)128U)
+#define FLASH_ERASE_QUEUE_SIZE            FLASH_PAGE_NUMBER
+#define FLASH_DIGEST_OFFSET_BASIS         0x811C9DC5U  /* FNV-1a 32-bit offset basis */
+#define FLASH_DIGEST_PRIME                0x01000193U  /* FNV-1a 32-bit prime */
+#define FLASH_ERASE_STATUS_SIZE           8U           /* Size of the erase status special command data */
+#define FLASH_RANGE_SIZE                  8U           /* Start and end addresses of a range erase */
+#define FLASH_RANGE_ERASE_SKIP_WRP        0x01U        /* Range erase option: keep the write protected pages */
+#define FLASH_SLOT_RECORD_MAGIC           0xA5B51000U  /* Upper bits of the second word of a slot record */
+#define FLASH_SLOT_RECORD_MAGIC_MASK      0xFFFFFF00U
+#define FLASH_SLOT_CMD_GET_STATUS         0x00U        /* Slot special command: get the slot status */
+#define FLASH_SLOT_CMD_SET_ACTIVE         0x01U        /* Slot special command: switch the active slot */
+#define FLASH_SLOT_STATUS_SIZE            13U          /* Size of the slot status special command data */
+#define FLASH_JOURNAL_START_MAGIC         0x4AU        /* Most significant byte of a journal start record */
+#define FLASH_JOURNAL_PAGE_MAGIC          0x50A50000U  /* Upper bits of the second word of a journal page record */
+#define FLASH_JOURNAL_PAGE_MAGIC_MASK     0xFFFFFF00U
+#define FLASH_JOURNAL_CMD_START           0x00U        /* Journal special command: start a new download */
+#define FLASH_JOURNAL_CMD_COMMIT_PAGE     0x01U        /* Journal special command: verify and record a page */
+#define FLASH_JOURNAL_CMD_GET_RESUME      0x02U        /* Journal special command: get the resume point */
+#define FLASH_JOURNAL_STATUS_SIZE         8U           /* Size of the journal resume point data */
+#define FLASH_WEAR_HEADER_MAGIC           0x57480000U  /* Second word of a wear log header, with the sequence number */
+#define FLASH_WEAR_COUNTER_MAGIC          0x57430000U  /* Second word of a wear log counter, with the page number */
+#define FLASH_WEAR_ERASE_MAGIC            0x57450000U  /* Second word of a wear log erase record, with the page number */
+#define FLASH_WEAR_MAGIC_MASK             0xFFFFFF00U
+#define FLASH_WEAR_ALL_PAGES              0xFFU        /* Page number of the mass erase records */
+#define FLASH_WEAR_COUNTER_MAX            0xFFFFU
+#define FLASH_ECC_SCAN_MAX_EVENTS         32U          /* Number of ECC events returned by the ECC scan */
+#define FLASH_ECC_EVENT_SIZE              5U           /* Address and type of an ECC event */
+#define FLASH_ECC_CORRECTED               0x01U        /* ECC event type: single error corrected */
+#define FLASH_ECC_UNCORRECTABLE           0x02U        /* ECC event type: double error detected */
 
 /* Private macro -------------------------------------------------------------*/
+#define FLASH_GET_PAGE(__ADDRESS__)       (((__ADDRESS__) - FLASH_START_ADDRESS) / FLASH_PAGE_SIZE)
+#define FLASH_IS_PAGE_PENDING(__PAGE__)   ((FlashErasePendingPages[(__PAGE__) >> 5U] & (1UL << ((__PAGE__) & 0x1FU))) != 0U)
+#define FLASH_IS_PAGE_ERASED(__PAGE__)    ((FlashErasedPages[(__PAGE__) >> 5U] & (1UL << ((__PAGE__) & 0x1FU))) != 0U)
+#define FLASH_IS_SLOT_METADATA(__ADDRESS__) (((__ADDRESS__) >= FLASH_SLOT_METADATA_ADDRESS) \
+                                             && ((__ADDRESS__) < (FLASH_SLOT_METADATA_ADDRESS + FLASH_SLOT_METADATA_SIZE)))
+#define FLASH_IS_JOURNAL(__ADDRESS__)     (((__ADDRESS__) >= FLASH_JOURNAL_ADDRESS) \
+                                           && ((__ADDRESS__) < (FLASH_JOURNAL_ADDRESS + FLASH_JOURNAL_SIZE)))
+#define FLASH_IS_WEAR_LOG(__ADDRESS__)    (((__ADDRESS__) >= FLASH_WEAR_LOG_ADDRESS) \
+                                           && ((__ADDRESS__) < (FLASH_WEAR_LOG_ADDRESS + FLASH_WEAR_LOG_SIZE)))
+#define FLASH_GET_SLOT_ADDRESS(__SLOT__)  (((__SLOT__) == FLASH_SLOT_A) ? FLASH_SLOT_A_ADDRESS : FLASH_SLOT_B_ADDRESS)
+#define FLASH_GET_ECC_ADDRESS()           (FLASH_START_ADDRESS + ((FLASH->ECCR & FLASH_ECCR_ADDR_ECC) * FLASH_PROG_STEP_SIZE))
+#define FLASH_IS_PAGE_SET(__PAGES__, __PAGE__) (((__PAGES__)[(__PAGE__) >> 5U] & (1UL << ((__PAGE__) & 0x1FU))) != 0U)
+
 /* Private variables ---------------------------------------------------------*/
+/* Pages waiting to be erased by interrupt, in the order they were requested by the host */
+static uint8_t FlashEraseQueue[FLASH_ERASE_QUEUE_SIZE];
+static volatile uint32_t FlashEraseQueueHead     = 0U;
+static volatile uint32_t FlashEraseQueueCount    = 0U;
+static volatile uint32_t FlashErasePendingPages[FLASH_PAGE_NUMBER / 32U];
+static volatile uint32_t FlashEraseOngoing       = 0U;
+static volatile uint32_t FlashEraseSuspended     = 0U;
+static volatile uint32_t FlashEraseErrors        = 0U;
+static volatile uint32_t FlashMassEraseOngoing   = 0U;
+static uint32_t FlashEraseStartTick              = 0U;
+
+/* Pages erased since the Open Bootloader started, used by the erase on first write mode */
+static volatile uint32_t FlashErasedPages[FLASH_PAGE_NUMBER / 32U];
+static FunctionalState FlashEraseOnWrite         = DISABLE;
+
+/* Number of double words that failed to be programmed since the last call of OPENBL_FLASH_GetWriteStatus() */
+static uint32_t FlashWriteErrors                 = 0U;
+
+/* Number of double words that failed to be programmed since reset, not cleared by any host command */
+static uint32_t FlashWriteErrorsTotal            = 0U;
+
+/* Active slot read from the slot records, FLASH_SLOT_NONE until they are scanned or when no record is valid */
+static uint32_t FlashActiveSlot                  = FLASH_SLOT_NONE;
+static uint32_t FlashActiveSlotSequence          = 0U;
+static uint32_t FlashSlotRecordsScanned          = 0U;
+
+/* Erase counters, loaded from the wear log the first time they are needed */
+static uint16_t FlashWearCounters[FLASH_PAGE_NUMBER];
+static uint32_t FlashWearLoaded                  = 0U;
+static uint32_t FlashWearCompacting              = 0U;
+static uint32_t FlashWearSequence                = 0U;
+static uint32_t FlashWearLogAddress              = 0U;  /* Current wear log page, 0 if there is none */
+static uint32_t FlashWearFreeAddress             = 0U;  /* Next erase record address, 0 if the page is full */
+
+/* Erase records reserved when the pages are queued, programmed after the end of their erase */
+static volatile uint32_t FlashWearRecordPages[FLASH_PAGE_NUMBER / 32U];
+static volatile uint32_t FlashWearReservedRecords = 0U;
+static volatile uint32_t FlashWearRecord          = 0U;  /* Second word of the next erase record, 0 if none */
+
+/* ECC double errors are reported by NMI, recorded during the ECC scan only */
+static volatile uint32_t FlashEccScanOngoing     = 0U;
+static volatile uint32_t FlashEccDoubleError     = 0U;
+static volatile uint32_t FlashEccDoubleErrorAddress = 0U;
+
+/* Trailing partial double word kept until the next contiguous write completes it or until it is flushed */
+static __ALIGNED(4) uint8_t FlashWriteCache[FLASH_PROG_STEP_SIZE];
+static uint32_t FlashWriteCacheAddress           = 0U;
+static uint32_t FlashWriteCacheCount             = 0U;
 
 /* Private function prototypes -----------------------------------------------*/
-static void OPENBL_FLASH_Program(uint32_t Address, uint64_t Data);
+static ErrorStatus OPENBL_FLASH_Program(uint32_t Address, uint64_t Data);
+static ErrorStatus OPENBL_FLASH_QueuePageErase(uint32_t Page);
+static void OPENBL_FLASH_AddPageErase(uint32_t Page, uint32_t Record);
+static void OPENBL_FLASH_StartNextErase(void);
+static void OPENBL_FLASH_StartMassErase(void);
+static uint32_t OPENBL_FLASH_GetPendingPagesNumber(void);
+static void OPENBL_FLASH_GetWriteProtectedPages(uint32_t *pPages);
+static uint32_t OPENBL_FLASH_ScanSlotRecords(uint32_t *pRecordAddress);
+static ErrorStatus OPENBL_FLASH_ErasePage(uint32_t Page);
+static ErrorStatus OPENBL_FLASH_IsPageWritable(uint32_t Page);
+static ErrorStatus OPENBL_FLASH_ProgramRecord(uint32_t Address, uint64_t Record);
+static void OPENBL_FLASH_ReadJournal(FLASH_JournalTypeDef *pJournal);
+static ErrorStatus OPENBL_FLASH_StartJournal(uint32_t ImageId, uint32_t FirstPage, uint32_t PagesNumber);
+static ErrorStatus OPENBL_FLASH_CommitJournalPage(uint32_t Page, uint32_t Crc);
+static uint32_t OPENBL_FLASH_IsPageBlank(uint32_t Page);
+static void OPENBL_FLASH_IncrementWearCounter(uint32_t Page);
+static void OPENBL_FLASH_LoadWearLog(void);
+static uint32_t OPENBL_FLASH_ReserveWearRecord(uint32_t Page);
+static void OPENBL_FLASH_SubmitWearRecord(void);
+static void OPENBL_FLASH_CompactWearLog(void);
+static void OPENBL_FLASH_ErasePageDone(ErrorStatus Status);
+static void OPENBL_FLASH_WaitForPageErase(uint32_t Page);
+static void OPENBL_FLASH_PrepareProgram(uint32_t Address);
+static void OPENBL_FLASH_ProgramWriteCache(void);
 static ErrorStatus OPENBL_FLASH_EnableWriteProtection(uint8_t *ListOfPages, uint32_t Length);
 static ErrorStatus OPENBL_FLASH_DisableWriteProtection(void);
 
 /* Exported variables --------------------------------------------------------*/
-OPENBL_MemoryTypeDef FLASH_Descriptor =
+const OPENBL_MemoryTypeDef FLASH_Descriptor =
 {
   FLASH_START_ADDRESS,
   FLASH_END_ADDRESS,
@@ -80,6 +208,12 @@ void OPENBL_FLASH_Lock(void)
   */
 void OPENBL_FLASH_OB_Unlock(void)
 {
+  /* The option bytes launch resets the device, program the cached data before */
+  OPENBL_FLASH_FlushWriteCache();
+
+  /* Option bytes programming uses the same controller as the background erase */
+  OPENBL_FLASH_WaitForPendingErase();
+
   HAL_FLASH_Unlock();
 
   HAL_FLASH_OB_Unlock();
@@ -92,11 +226,88 @@ void OPENBL_FLASH_OB_Unlock(void)
   */
 uint8_t OPENBL_FLASH_Read(uint32_t Address)
 {
-  return (*(uint8_t *)(Address));
+  uint8_t data;
+
+  /* Do not return the content of a double word still waiting to be programmed */
+  if (OPENBL_PROG_IsBusy() != 0U)
+  {
+    OPENBL_FLASH_WaitForProgram();
+  }
+
+  /* The bytes of the cached double word are not programmed yet */
+  if ((Address >= FlashWriteCacheAddress) && (Address < (FlashWriteCacheAddress + FlashWriteCacheCount)))
+  {
+    data = FlashWriteCache[Address - FlashWriteCacheAddress];
+  }
+  else
+  {
+    /* Do not return the old content of a page that is still waiting to be erased */
+    if ((Address >= FLASH_START_ADDRESS) && (Address < FLASH_END_ADDRESS))
+    {
+      OPENBL_FLASH_WaitForPageErase(FLASH_GET_PAGE(Address));
+    }
+
+    data = *(uint8_t *)(Address);
+  }
+
+  return data;
+}
+
+/**
+  * @brief  This function is used to read a block of data from a given address.
+  * @note   The block is read in place, unless it contains bytes of the cached double word: it is then
+  *         copied in the buffer byte per byte as by OPENBL_FLASH_Read().
+  * @param  Address The address of the block, the block must be inside the FLASH.
+  * @param  pBuffer Pointer to the buffer used when the block can not be read in place.
+  * @param  BufferSize The size of the buffer in bytes.
+  * @param  pLength Pointer to the length of the block, updated with the number of bytes returned.
+  * @retval Returns a pointer to the bytes of the block.
+  */
+const uint8_t *OPENBL_FLASH_ReadBlock(uint32_t Address, uint8_t *pBuffer, uint32_t BufferSize, uint32_t *pLength)
+{
+  uint32_t page;
+  uint32_t index;
+  uint32_t length = *pLength;
+  const uint8_t *p_data;
+
+  if (OPENBL_PROG_IsBusy() != 0U)
+  {
+    OPENBL_FLASH_WaitForProgram();
+  }
+
+  if ((FlashWriteCacheCount != 0U) && (Address < (FlashWriteCacheAddress + FlashWriteCacheCount))
+      && (FlashWriteCacheAddress < (Address + length)))
+  {
+    length = (length > BufferSize) ? BufferSize : length;
+
+    for (index = 0U; index < length; index++)
+    {
+      pBuffer[index] = OPENBL_FLASH_Read(Address + index);
+    }
+
+    p_data = pBuffer;
+  }
+  else
+  {
+    for (page = FLASH_GET_PAGE(Address); page <= FLASH_GET_PAGE(Address + length - 1U); page++)
+    {
+      OPENBL_FLASH_WaitForPageErase(page);
+    }
+
+    p_data = (const uint8_t *)Address;
+  }
+
+  *pLength = length;
+
+  return p_data;
 }
 
 /**
   * @brief  This function is used to write data in FLASH memory.
+  * @note   The FLASH is programmed by double words. When the data does not end on a double word
+  *         boundary, the trailing bytes are cached and programmed either with the next write if it
+  *         continues at the next address, or padded with 0xFF when a non contiguous write, a flush,
+  *         an erase or a jump occurs. So the host can send a stream in chunks of any size.
   * @param  Address The address where that data will be written.
   * @param  pData The data to be written.
   * @param  DataLength The length of the data to be written.
@@ -106,56 +317,199 @@ void OPENBL_FLASH_Write(uint32_t Address, uint8_t *pData, uint32_t DataLength)
 {
   uint32_t index;
   __ALIGNED(4) uint8_t data[FLASH_PROG_STEP_SIZE] = {0x0U};
-  uint8_t remaining;
 
   if ((pData != NULL) && (DataLength != 0U))
   {
+    /* The bytes of an image to be verified are hashed as they arrive */
+    OPENBL_SIGN_Update(Address, pData, DataLength);
+
+    /* Hold the background erase while programming, the flash can only do one operation at a time */
+    OPENBL_FLASH_SuspendErase();
+
     /* Unlock the flash memory for write operation */
     OPENBL_FLASH_Unlock();
 
+    /* A write that does not continue the cached double word can not complete it */
+    if ((FlashWriteCacheCount != 0U) && (Address != (FlashWriteCacheAddress + FlashWriteCacheCount)))
+    {
+      OPENBL_FLASH_ProgramWriteCache();
+    }
+
+    /* Data not aligned on a double word starts a new cached double word, its first bytes stay erased */
+    if ((FlashWriteCacheCount == 0U) && ((Address % FLASH_PROG_STEP_SIZE) != 0U))
+    {
+      for (index = 0U; index < FLASH_PROG_STEP_SIZE; index++)
+      {
+        FlashWriteCache[index] = 0xFFU;
+      }
+
+      FlashWriteCacheAddress = Address - (Address % FLASH_PROG_STEP_SIZE);
+      FlashWriteCacheCount   = Address % FLASH_PROG_STEP_SIZE;
+    }
+
+    /* Complete the cached double word and program it once full */
+    if (FlashWriteCacheCount != 0U)
+    {
+      while ((DataLength > 0U) && (FlashWriteCacheCount < FLASH_PROG_STEP_SIZE))
+      {
+        FlashWriteCache[FlashWriteCacheCount] = *pData;
+
+        FlashWriteCacheCount++;
+        pData++;
+        DataLength--;
+      }
+
+      Address = FlashWriteCacheAddress + FlashWriteCacheCount;
+
+      if (FlashWriteCacheCount == FLASH_PROG_STEP_SIZE)
+      {
+        OPENBL_FLASH_ProgramWriteCache();
+      }
+    }
+
     /* Program double-word by double-word (8 bytes) */
     while ((DataLength >> 3U) > 0U)
     {
+      /* Only block when reaching a page that is not erased yet */
+      OPENBL_FLASH_PrepareProgram(Address);
+
       for (index = 0U; index < FLASH_PROG_STEP_SIZE; index++)
       {
         data[index] = *(pData + index);
       }
 
-      OPENBL_FLASH_Program(Address, (uint64_t)(*((uint64_t *)((uint32_t)data))));
+      if (OPENBL_FLASH_Program(Address, (uint64_t)(*((uint64_t *)((uint32_t)data)))) != SUCCESS)
+      {
+        FlashWriteErrors++;
+      }
 
       Address    += FLASH_PROG_STEP_SIZE;
       pData      += FLASH_PROG_STEP_SIZE;
       DataLength -= FLASH_PROG_STEP_SIZE;
     }
 
-    /* If remaining count, go back to fill the rest with 0xFF */
+    /* If remaining count, keep it until the double word is completed or flushed */
     if (DataLength > 0U)
     {
-      remaining = FLASH_PROG_STEP_SIZE - DataLength;
-
-      /* Copy the remaining bytes */
-      for (index = 0U; index < DataLength; index++)
-      {
-        data[index] = *(pData + index);
-      }
-
-      /* Fill the upper bytes with 0xFF */
-      for (index = 0U; index < remaining; index++)
+      /* Copy the remaining bytes and fill the upper bytes with 0xFF */
+      for (index = 0U; index < FLASH_PROG_STEP_SIZE; index++)
       {
-        data[index + DataLength] = 0xFFU;
+        FlashWriteCache[index] = (index < DataLength) ? *(pData + index) : 0xFFU;
       }
 
-      /* FLASH word program */
-      OPENBL_FLASH_Program(Address, (uint64_t)(*((uint64_t *)((uint32_t)data))));
+      FlashWriteCacheAddress = Address;
+      FlashWriteCacheCount   = DataLength;
     }
 
-    /* Lock the Flash to disable the flash control register access */
-    OPENBL_FLASH_Lock();
+    /* Let the pending erase operations go on, the flash is locked once there is nothing left to do */
+    OPENBL_FLASH_ResumeErase();
+  }
+}
+
+/**
+  * @brief  Program the cached partial double word, if any, padded with 0xFF, and wait until all the
+  *         written data is programmed.
+  * @retval None.
+  */
+void OPENBL_FLASH_FlushWriteCache(void)
+{
+  if (FlashWriteCacheCount != 0U)
+  {
+    OPENBL_FLASH_SuspendErase();
+
+    OPENBL_FLASH_Unlock();
+
+    OPENBL_FLASH_ProgramWriteCache();
+
+    OPENBL_FLASH_ResumeErase();
+  }
+
+  /* The data is in the FLASH once the programming engine is idle */
+  OPENBL_FLASH_WaitForProgram();
+}
+
+/**
+  * @brief  This function is used to process the flush special command.
+  *         Buffer1 is empty. The status is NACK if a FLASH programming error occurred since the
+  *         previous flush or CRC command.
+  * @param  SpecialCmd Pointer to the OPENBL_SpecialCmdTypeDef structure.
+  * @param  SendByte The function used to send one byte through the detected interface.
+  * @retval None.
+  */
+void OPENBL_FLASH_FlushCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte)
+{
+  ErrorStatus status = ERROR;
+
+  if (SpecialCmd->SizeBuffer1 == 0U)
+  {
+    OPENBL_FLASH_FlushWriteCache();
+
+    status = OPENBL_FLASH_GetWriteStatus();
+  }
+
+  if (SpecialCmd->CmdType == OPENBL_SPECIAL_CMD)
+  {
+    /* Send NULL data size */
+    Common_SendHalfWord(SendByte, 0U);
+  }
+
+  Common_SendSpecialCmdStatus(SendByte, status);
+}
+
+/**
+  * @brief  Return the status of the FLASH write operations done since the previous call.
+  * @note   The memory Write callback has no return value, the programming errors are kept here so
+  *         that they are reported to the host by the CRC verify command.
+  * @retval An ErrorStatus enumeration value:
+  *          - SUCCESS: All the double words were programmed
+  *          - ERROR:   At least one double word failed to be programmed
+  */
+ErrorStatus OPENBL_FLASH_GetWriteStatus(void)
+{
+  ErrorStatus status;
+
+  OPENBL_FLASH_WaitForProgram();
+
+  status = (FlashWriteErrors == 0U) ? SUCCESS : ERROR;
+
+  FlashWriteErrorsTotal += FlashWriteErrors;
+  FlashWriteErrors       = 0U;
+
+  return status;
+}
+
+/**
+  * @brief  Return the number of FLASH programming errors since reset.
+  * @note   Unlike OPENBL_FLASH_GetWriteStatus(), the count is not cleared, so that the signature
+  *         verification detects the errors that occurred since an image was declared whatever the
+  *         commands sent in between.
+  * @retval The number of double words that failed to be programmed.
+  */
+uint32_t OPENBL_FLASH_GetWriteErrorCount(void)
+{
+  OPENBL_FLASH_WaitForProgram();
+
+  return FlashWriteErrorsTotal + FlashWriteErrors;
+}
+
+/**
+  * @brief  Wait until the double words queued to the programming engine are programmed.
+  * @note   The programming errors are kept for OPENBL_FLASH_GetWriteStatus(). Also used by the OTP
+  *         interface, which is programmed by the same engine.
+  * @retval None.
+  */
+void OPENBL_FLASH_WaitForProgram(void)
+{
+  if (OPENBL_PROG_WaitForCompletion() != SUCCESS)
+  {
+    FlashWriteErrors++;
   }
 }
 
 /**
   * @brief  This function is used to jump to a given address.
+  * @note   Once a public key is programmed, a jump to an image whose signature is not verified is
+  *         refused and a NACK is sent after the ACK of the Go command.
   * @param  Address The address where the function will jump.
   * @retval None.
   */
@@ -163,18 +517,39 @@ void OPENBL_FLASH_JumpToAddress(uint32_t Address)
 {
   Function_Pointer jump_to_address;
 
-  /* De-initialize all HW resources used by the Open Bootloader to their reset values */
-  OPENBL_DeInit();
+  /* The application must not start before all the data is programmed and the requested pages are erased */
+  OPENBL_FLASH_FlushWriteCache();
+
+  OPENBL_FLASH_WaitForPendingErase();
+
+  /* In A/B slot mode, a jump to the start of a slot starts the active slot */
+  if (((Address == FLASH_SLOT_A_ADDRESS) || (Address == FLASH_SLOT_B_ADDRESS))
+      && (OPENBL_FLASH_GetActiveSlot() != FLASH_SLOT_NONE))
+  {
+    Address = FLASH_GET_SLOT_ADDRESS(OPENBL_FLASH_GetActiveSlot());
+  }
+
+  /* Once a public key is programmed, only an image with a verified signature is started */
+  if (OPENBL_SIGN_IsJumpAllowed(Address) == SUCCESS)
+  {
+    /* De-initialize all HW resources used by the Open Bootloader to their reset values */
+    OPENBL_DeInit();
 
-  /* Enable IRQ */
-  Common_EnableIrq();
+    /* Enable IRQ */
+    Common_EnableIrq();
 
-  jump_to_address = (Function_Pointer)(*(__IO uint32_t *)(Address + 4U));
+    jump_to_address = (Function_Pointer)(*(__IO uint32_t *)(Address + 4U));
 
-  /* Initialize user application's stack pointer */
-  Common_SetMsp(*(__IO uint32_t *) Address);
+    /* Initialize user application's stack pointer */
+    Common_SetMsp(*(__IO uint32_t *) Address);
 
-  jump_to_address();
+    jump_to_address();
+  }
+  else
+  {
+    /* The Go command has already acknowledged the address, the refusal is reported after it */
+    Common_SendNack();
+  }
 }
 
 /**
@@ -264,38 +639,36 @@ ErrorStatus OPENBL_FLASH_SetWriteProtection(FunctionalState State, uint8_t *List
 
 /**
   * @brief  This function is used to start FLASH mass erase operation.
+  * @note   All the pages except the wear log pages are queued to the background erase and this function
+  *         returns at once, the accesses to the FLASH wait for the pages they use. The host can poll the
+  *         erase status special command meanwhile, it also reports the page erase failures. The device
+  *         has a single bank, so the bank 1 erase is a mass erase and there is no bank 2.
   * @param  *p_Data Pointer to the buffer that contains mass erase operation options.
   * @param  DataLength Size of the Data buffer.
   * @retval An ErrorStatus enumeration value:
-  *          - SUCCESS: Mass erase operation done
-  *          - ERROR:   Mass erase operation failed or the value of one parameter is not ok
+  *          - SUCCESS: Mass erase operation started
+  *          - ERROR:   The value of one parameter is not ok
   */
 ErrorStatus OPENBL_FLASH_MassErase(uint8_t *p_Data, uint32_t DataLength)
 {
-  uint32_t page_error;
-  ErrorStatus status   = SUCCESS;
-  FLASH_EraseInitTypeDef erase_init_struct;
-
-  /* Unlock the flash memory for erase operation */
-  OPENBL_FLASH_Unlock();
-
-  /* Clear error programming flags */
-  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+  uint16_t erase_code;
+  ErrorStatus status = SUCCESS;
 
-  erase_init_struct.TypeErase = FLASH_TYPEERASE_MASSERASE;
+  /* Let the write and page erase operations requested before finish first */
+  OPENBL_FLASH_FlushWriteCache();
+  OPENBL_FLASH_WaitForPendingErase();
 
   if (DataLength >= 2U)
   {
-    if (status == SUCCESS)
+    erase_code = *(uint16_t *)(p_Data);
+
+    if ((erase_code == FLASH_MASS_ERASE) || (erase_code == FLASH_BANK1_ERASE))
     {
-      if (HAL_FLASHEx_Erase(&erase_init_struct, &page_error) != HAL_OK)
-      {
-        status = ERROR;
-      }
-      else
-      {
-        status = SUCCESS;
-      }
+      OPENBL_FLASH_StartMassErase();
+    }
+    else
+    {
+      status = ERROR;
     }
   }
   else
@@ -303,14 +676,16 @@ ErrorStatus OPENBL_FLASH_MassErase(uint8_t *p_Data, uint32_t DataLength)
     status = ERROR;
   }
 
-  /* Lock the Flash to disable the flash control register access */
-  OPENBL_FLASH_Lock();
-
   return status;
 }
 
 /**
   * @brief  This function is used to erase the specified FLASH pages.
+  * @note   The pages are only queued here and erased by the FLASH interrupt while the interface waits
+  *         for the next command. The device has a single bank, so the CPU stalls on every FLASH access
+  *         during a page erase: the erase is held while a command is received and processed, nothing
+  *         overlaps the erase but the idle time between commands. The writer waits for a page only if
+  *         it is still in the queue. An erase failure is reported by the next call of this function.
   * @param  *p_Data Pointer to the buffer that contains erase operation options.
   * @param  DataLength Size of the Data buffer.
   * @retval An ErrorStatus enumeration value:
@@ -321,48 +696,48 @@ ErrorStatus OPENBL_FLASH_Erase(uint8_t *p_Data, uint32_t DataLength)
 {
   uint32_t counter;
   uint32_t pages_number;
-  uint32_t page_error   = 0U;
   uint32_t errors       = 0U;
   ErrorStatus status    = SUCCESS;
-  FLASH_EraseInitTypeDef erase_init_struct;
 
-  /* Unlock the flash memory for erase operation */
-  OPENBL_FLASH_Unlock();
+  /* The cached data was written before the erase request */
+  OPENBL_FLASH_FlushWriteCache();
 
-  /* Clear error programming flags */
-  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+  /* Report the failures of the previous background erase operations */
+  errors = FlashEraseErrors;
+  FlashEraseErrors = 0U;
+
+  if ((FlashEraseQueueCount == 0U) && (FlashEraseOngoing == 0U))
+  {
+    FlashEraseStartTick = HAL_GetTick();
+  }
 
   pages_number  = (uint32_t)(*(uint16_t *)(p_Data));
 
   /* The sector number size is 2 bytes */
   p_Data += 2U;
 
-  erase_init_struct.TypeErase = FLASH_TYPEERASE_PAGES;
-  erase_init_struct.NbPages   = 1U;
-
   for (counter = 0U; ((counter < pages_number) && (counter < (DataLength / 2U))) ; counter++)
   {
-    erase_init_struct.Page = ((uint32_t)(*(uint16_t *)(p_Data)));
-
-    if (status != ERROR)
+    if (OPENBL_FLASH_IsPageWritable((uint32_t)(*(uint16_t *)(p_Data))) != SUCCESS)
     {
-      if (HAL_FLASHEx_Erase(&erase_init_struct, &page_error) != HAL_OK)
-      {
-        errors++;
-      }
+      errors++;
+    }
+    else if (OPENBL_FLASH_QueuePageErase((uint32_t)(*(uint16_t *)(p_Data))) != SUCCESS)
+    {
+      errors++;
     }
     else
     {
-      /* Reset the status for next erase operation */
-      status = SUCCESS;
+      OPENBL_SIGN_Invalidate(FLASH_START_ADDRESS + ((uint32_t)(*(uint16_t *)(p_Data)) * FLASH_PAGE_SIZE),
+                             FLASH_PAGE_SIZE);
     }
 
     /* The page number size is 2 bytes */
     p_Data += 2U;
   }
 
-  /* Lock the Flash to disable the flash control register access */
-  OPENBL_FLASH_Lock();
+  /* Start the erase of the first queued page, the next ones are chained by the FLASH interrupt */
+  OPENBL_FLASH_StartNextErase();
 
   if (errors > 0)
   {
@@ -376,21 +751,1716 @@ ErrorStatus OPENBL_FLASH_Erase(uint8_t *p_Data, uint32_t DataLength)
   return status;
 }
 
+/**
+  * @brief  This function is used to process the range erase special command.
+  *         Buffer1 contains one option byte followed by up to 15 ranges. A range is a start address
+  *         and an end address (excluded), 4 bytes each MSB first. Every page that overlaps a range is
+  *         erased. With the option bit 0 set, the write protected pages are kept, so that the whole
+  *         FLASH range can be given to erase everything but the protected area. The active slot and
+  *         the slot records are always kept in A/B slot mode.
+  *         The response data lists the erased page runs, the first page and the number of pages,
+  *         one byte each. The status is NACK if a range is not valid, if the read protection is active
+  *         or if a page failed to be erased since the previous Erase or range erase command.
+  * @note   The pages are erased in background like with the Erase command, so an erase failure is
+  *         reported by the next one.
+  * @param  SpecialCmd Pointer to the OPENBL_SpecialCmdTypeDef structure.
+  * @param  SendByte The function used to send one byte through the detected interface.
+  * @retval None.
+  */
+void OPENBL_FLASH_RangeEraseCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte)
+{
+  uint32_t index;
+  uint32_t page;
+  uint32_t start_address;
+  uint32_t end_address;
+  uint32_t runs_number = 0U;
+  uint32_t pages[FLASH_PAGE_NUMBER / 32U] = {0U};
+  uint32_t protected_pages[FLASH_PAGE_NUMBER / 32U] = {0U};
+  uint8_t runs[FLASH_PAGE_NUMBER];
+  ErrorStatus status = SUCCESS;
 
-/* Private functions ---------------------------------------------------------*/
+  if ((SpecialCmd->SizeBuffer1 <= 1U) || (((SpecialCmd->SizeBuffer1 - 1U) % FLASH_RANGE_SIZE) != 0U)
+      || (Common_GetProtectionStatus() != RESET))
+  {
+    status = ERROR;
+  }
+  else
+  {
+    if ((SpecialCmd->Buffer1[0] & FLASH_RANGE_ERASE_SKIP_WRP) != 0U)
+    {
+      OPENBL_FLASH_GetWriteProtectedPages(protected_pages);
+    }
+
+    /* Select the pages of all the ranges first, so that nothing is erased if one of them is not valid */
+    for (index = 1U; (index < SpecialCmd->SizeBuffer1) && (status == SUCCESS); index += FLASH_RANGE_SIZE)
+    {
+      start_address = Common_GetWord(&SpecialCmd->Buffer1[index]);
+      end_address   = Common_GetWord(&SpecialCmd->Buffer1[index + 4U]);
+
+      if ((start_address < FLASH_START_ADDRESS) || (start_address >= end_address) || (end_address > FLASH_END_ADDRESS))
+      {
+        status = ERROR;
+      }
+      else
+      {
+        for (page = FLASH_GET_PAGE(start_address); page <= FLASH_GET_PAGE(end_address - 1U); page++)
+        {
+          if ((FLASH_IS_PAGE_SET(protected_pages, page) == 0U) && (OPENBL_FLASH_IsPageWritable(page) == SUCCESS))
+          {
+            pages[page >> 5U] |= (1UL << (page & 0x1FU));
+          }
+        }
+      }
+    }
+  }
+
+  if (status == SUCCESS)
+  {
+    /* The cached data was written before the erase request */
+    OPENBL_FLASH_FlushWriteCache();
+
+    /* Report the failures of the previous background erase operations */
+    if (FlashEraseErrors != 0U)
+    {
+      status = ERROR;
+    }
+
+    FlashEraseErrors = 0U;
+
+    if ((FlashEraseQueueCount == 0U) && (FlashEraseOngoing == 0U))
+    {
+      FlashEraseStartTick = HAL_GetTick();
+    }
+
+    /* Coalesce the selected pages into runs, queued by increasing page number */
+    page = 0U;
+
+    while (page < FLASH_PAGE_NUMBER)
+    {
+      if (FLASH_IS_PAGE_SET(pages, page))
+      {
+        runs[runs_number * 2U] = (uint8_t)page;
+
+        while ((page < FLASH_PAGE_NUMBER) && FLASH_IS_PAGE_SET(pages, page))
+        {
+          if (OPENBL_FLASH_QueuePageErase(page) != SUCCESS)
+          {
+            status = ERROR;
+          }
+
+          OPENBL_SIGN_Invalidate(FLASH_START_ADDRESS + (page * FLASH_PAGE_SIZE), FLASH_PAGE_SIZE);
+          page++;
+        }
+
+        runs[(runs_number * 2U) + 1U] = (uint8_t)(page - runs[runs_number * 2U]);
+        runs_number++;
+      }
+      else
+      {
+        page++;
+      }
+    }
+
+    OPENBL_FLASH_StartNextErase();
+  }
+
+  if (SpecialCmd->CmdType == OPENBL_SPECIAL_CMD)
+  {
+    Common_SendHalfWord(SendByte, (uint16_t)(runs_number * 2U));
+
+    for (index = 0U; index < (runs_number * 2U); index++)
+    {
+      SendByte(runs[index]);
+    }
+  }
+
+  Common_SendSpecialCmdStatus(SendByte, status);
+}
 
 /**
-  * @brief  Program double word at a specified FLASH address.
-  * @param  Address specifies the address to be programmed.
-  * @param  Data specifies the data to be programmed.
+  * @brief  Hold the background erase, after the completion of the ongoing page erase if any.
+  * @note   The FLASH is not locked by the FLASH interrupt while the erase is held, so that the
+  *         caller can program it. The interfaces also hold it from the reception of a command opcode
+  *         until they wait for the next one.
   * @retval None.
   */
-static void OPENBL_FLASH_Program(uint32_t Address, uint64_t Data)
+void OPENBL_FLASH_SuspendErase(void)
 {
-  /* Clear all FLASH errors flags before starting write operation */
-  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+  FlashEraseSuspended = 1U;
+
+  while (FlashEraseOngoing != 0U)
+  {
+    OPENBL_IWDG_Refresh();
+  }
+}
+
+/**
+  * @brief  Release the background erase held by OPENBL_FLASH_SuspendErase().
+  * @retval None.
+  */
+void OPENBL_FLASH_ResumeErase(void)
+{
+  FlashEraseSuspended = 0U;
+
+  OPENBL_FLASH_StartNextErase();
+}
 
-  HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, Address, Data);
+/**
+  * @brief  This function is used to wait until all the queued FLASH pages are erased.
+  * @note   The erase records of the wear log are programmed too.
+  * @retval None.
+  */
+void OPENBL_FLASH_WaitForPendingErase(void)
+{
+  /* The FLASH controller does one operation at a time, the queued double words are programmed first */
+  OPENBL_FLASH_WaitForProgram();
+
+  FlashEraseSuspended = 0U;
+
+  OPENBL_FLASH_StartNextErase();
+
+  while ((FlashEraseQueueCount != 0U) || (FlashEraseOngoing != 0U))
+  {
+    OPENBL_IWDG_Refresh();
+  }
+
+  /* A failed erase record is not a write error of the host, the erase counters are only approximate */
+  (void)OPENBL_PROG_WaitForCompletion();
+}
+
+/**
+  * @brief  This function is used to process the erase status special command.
+  *         Buffer1 is empty. The response data is 8 bytes, MSB first:
+  *         - 1 byte: 0x01 if an erase operation is ongoing, 0x00 otherwise
+  *         - 1 byte: 0x01 if a background erase failed since the last Erase command, 0x00 otherwise
+  *         - 2 bytes: the number of pages still waiting to be erased, including the pages of a mass erase
+  *         - 4 bytes: the time in ms since the start of the erase operations, 0 when idle
+  * @param  SpecialCmd Pointer to the OPENBL_SpecialCmdTypeDef structure.
+  * @param  SendByte The function used to send one byte through the detected interface.
+  * @retval None.
+  */
+void OPENBL_FLASH_EraseStatusCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte)
+{
+  uint32_t pages_number;
+  uint32_t elapsed    = 0U;
+  uint8_t busy        = 0U;
+  ErrorStatus status  = ERROR;
+
+  if (SpecialCmd->SizeBuffer1 == 0U)
+  {
+    status = SUCCESS;
+  }
+
+  pages_number = OPENBL_FLASH_GetPendingPagesNumber();
+
+  if (pages_number != 0U)
+  {
+    busy    = 1U;
+    elapsed = HAL_GetTick() - FlashEraseStartTick;
+  }
+
+  if (SpecialCmd->CmdType == OPENBL_SPECIAL_CMD)
+  {
+    if (status == SUCCESS)
+    {
+      Common_SendHalfWord(SendByte, FLASH_ERASE_STATUS_SIZE);
+
+      SendByte(busy);
+      SendByte((FlashEraseErrors != 0U) ? 1U : 0U);
+      Common_SendHalfWord(SendByte, (uint16_t)pages_number);
+      Common_SendWord(SendByte, elapsed);
+    }
+    else
+    {
+      /* Send NULL data size */
+      Common_SendHalfWord(SendByte, 0U);
+    }
+  }
+
+  Common_SendSpecialCmdStatus(SendByte, status);
+}
+
+/**
+  * @brief  Enable or disable the erase on first write mode.
+  * @note   When enabled, a page that has not been erased since the Open Bootloader started is
+  *         erased automatically the first time it is written. Pages erased by an Erase or a Mass
+  *         Erase command are considered as already erased.
+  * @param  State Can be one of these values:
+  *         @arg DISABLE: The host must erase the pages before writing them
+  *         @arg ENABLE: The pages are erased on first write
+  * @retval None.
+  */
+void OPENBL_FLASH_SetEraseOnWrite(FunctionalState State)
+{
+  FlashEraseOnWrite = State;
+}
+
+/**
+  * @brief  This function is used to process the erase on first write special command.
+  *         Buffer1 contains one byte, 0x00 to disable the mode or 0x01 to enable it.
+  * @param  SpecialCmd Pointer to the OPENBL_SpecialCmdTypeDef structure.
+  * @param  SendByte The function used to send one byte through the detected interface.
+  * @retval None.
+  */
+void OPENBL_FLASH_EraseOnWriteCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte)
+{
+  ErrorStatus status = ERROR;
+
+  if ((SpecialCmd->SizeBuffer1 == 1U) && (SpecialCmd->Buffer1[0] <= 1U))
+  {
+    OPENBL_FLASH_SetEraseOnWrite((SpecialCmd->Buffer1[0] == 1U) ? ENABLE : DISABLE);
+
+    status = SUCCESS;
+  }
+
+  if (SpecialCmd->CmdType == OPENBL_SPECIAL_CMD)
+  {
+    /* Send NULL data size */
+    Common_SendHalfWord(SendByte, 0U);
+  }
+
+  Common_SendSpecialCmdStatus(SendByte, status);
+}
+
+/**
+  * @brief  Compute the digest of a FLASH page.
+  * @note   The digest is a FNV-1a hash computed on the 32-bit words of the page, the host computes
+  *         the same value on its image to find the pages that must be updated.
+  *         The page is read four words per iteration: the loads of a group are independent of the
+  *         multiplications of the previous one, so they are issued while the FLASH is still busy.
+  * @param  Page The page number.
+  * @retval Returns the digest of the page.
+  */
+uint32_t OPENBL_FLASH_GetPageDigest(uint32_t Page)
+{
+  uint32_t index;
+  uint32_t word0;
+  uint32_t word1;
+  uint32_t word2;
+  uint32_t word3;
+  uint32_t digest = FLASH_DIGEST_OFFSET_BASIS;
+  const uint32_t *p_word;
+
+  /* No program or erase operation can modify the page once these return */
+  OPENBL_FLASH_FlushWriteCache();
+  OPENBL_FLASH_WaitForPageErase(Page);
+
+  p_word = (const uint32_t *)(FLASH_START_ADDRESS + (Page * FLASH_PAGE_SIZE));
+
+  for (index = 0U; index < (FLASH_PAGE_SIZE / 4U); index += 4U)
+  {
+    word0 = p_word[index];
+    word1 = p_word[index + 1U];
+    word2 = p_word[index + 2U];
+    word3 = p_word[index + 3U];
+
+    digest = (digest ^ word0) * FLASH_DIGEST_PRIME;
+    digest = (digest ^ word1) * FLASH_DIGEST_PRIME;
+    digest = (digest ^ word2) * FLASH_DIGEST_PRIME;
+    digest = (digest ^ word3) * FLASH_DIGEST_PRIME;
+  }
+
+  return digest;
+}
+
+/**
+  * @brief  This function is used to process the page digest special command.
+  *         Buffer1 contains the first page and the number of pages, one byte each, or is empty to
+  *         get the digest of all the pages. The response data is one 32-bit digest per page, MSB first.
+  *         The status is NACK if the pages are not valid or if the read protection is active.
+  * @note   Used for delta updates: the host compares the digests with its image, then only writes the
+  *         pages that differ, with the erase on first write mode enabled so that only these pages
+  *         are erased.
+  * @param  SpecialCmd Pointer to the OPENBL_SpecialCmdTypeDef structure.
+  * @param  SendByte The function used to send one byte through the detected interface.
+  * @retval None.
+  */
+void OPENBL_FLASH_PageDigestCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte)
+{
+  uint32_t page;
+  uint32_t first_page   = 0U;
+  uint32_t pages_number = FLASH_PAGE_NUMBER;
+  ErrorStatus status    = SUCCESS;
+
+  if (SpecialCmd->SizeBuffer1 == 2U)
+  {
+    first_page   = SpecialCmd->Buffer1[0];
+    pages_number = SpecialCmd->Buffer1[1];
+  }
+  else if (SpecialCmd->SizeBuffer1 != 0U)
+  {
+    status = ERROR;
+  }
+  else
+  {
+    /* Digest of all the pages */
+  }
+
+  /* The digests of the pages would tell what the Read memory command hides */
+  if (((first_page + pages_number) > FLASH_PAGE_NUMBER) || (Common_GetProtectionStatus() != RESET))
+  {
+    status = ERROR;
+  }
+
+  if (status != SUCCESS)
+  {
+    pages_number = 0U;
+  }
+
+  if (SpecialCmd->CmdType == OPENBL_SPECIAL_CMD)
+  {
+    Common_SendHalfWord(SendByte, (uint16_t)(pages_number * 4U));
+
+    for (page = first_page; page < (first_page + pages_number); page++)
+    {
+      Common_SendWord(SendByte, OPENBL_FLASH_GetPageDigest(page));
+
+      OPENBL_IWDG_Refresh();
+    }
+  }
+
+  Common_SendSpecialCmdStatus(SendByte, status);
+}
+
+/**
+  * @brief  Return the active application slot.
+  * @note   The slot records are double words appended in two metadata pages, the record with the
+  *         highest sequence number gives the active slot. They are scanned once and then cached.
+  * @retval FLASH_SLOT_A, FLASH_SLOT_B or FLASH_SLOT_NONE when the A/B slot mode is not in use.
+  */
+uint32_t OPENBL_FLASH_GetActiveSlot(void)
+{
+  uint32_t record_address;
+
+  if (FlashSlotRecordsScanned == 0U)
+  {
+    FlashActiveSlot         = OPENBL_FLASH_ScanSlotRecords(&record_address);
+    FlashSlotRecordsScanned = 1U;
+  }
+
+  return FlashActiveSlot;
+}
+
+/**
+  * @brief  Switch the active application slot.
+  * @note   The switch is a single double word program: a power loss leaves either the previous record
+  *         or the new one as the newest valid record. When the page of the newest record is full, the
+  *         other metadata page is erased and used, the previous records stay valid meanwhile.
+  *         The slot must contain a vector table, with the stack pointer in RAM and the reset handler
+  *         in the slot.
+  * @param  Slot The slot to be activated, FLASH_SLOT_A or FLASH_SLOT_B.
+  * @retval An ErrorStatus enumeration value:
+  *          - SUCCESS: The slot is active
+  *          - ERROR:   The slot is not valid or the record failed to be programmed
+  */
+ErrorStatus OPENBL_FLASH_SetActiveSlot(uint32_t Slot)
+{
+  uint32_t index;
+  uint32_t slot_address;
+  uint32_t stack_pointer;
+  uint32_t reset_handler;
+  uint32_t record_address = 0U;
+  uint32_t active_slot;
+  uint64_t record;
+  ErrorStatus status = SUCCESS;
+
+  /* The new image must be fully programmed */
+  OPENBL_FLASH_FlushWriteCache();
+  OPENBL_FLASH_WaitForPendingErase();
+
+  if ((Slot != FLASH_SLOT_A) && (Slot != FLASH_SLOT_B))
+  {
+    status = ERROR;
+  }
+  else
+  {
+    slot_address  = FLASH_GET_SLOT_ADDRESS(Slot);
+    stack_pointer = *(__IO uint32_t *)slot_address;
+    reset_handler = *(__IO uint32_t *)(slot_address + 4U);
+
+    if ((stack_pointer <= RAM_START_ADDRESS) || (stack_pointer > RAM_END_ADDRESS)
+        || (reset_handler < slot_address) || (reset_handler >= (slot_address + FLASH_SLOT_SIZE))
+        || (FlashWriteErrors != 0U))
+    {
+      status = ERROR;
+    }
+  }
+
+  if (status == SUCCESS)
+  {
+    active_slot = OPENBL_FLASH_ScanSlotRecords(&record_address);
+
+    if (active_slot == FLASH_SLOT_NONE)
+    {
+      /* First record, the metadata pages may contain anything */
+      for (index = 0U; index < (FLASH_SLOT_METADATA_SIZE / FLASH_PAGE_SIZE); index++)
+      {
+        if (OPENBL_FLASH_ErasePage(FLASH_GET_PAGE(FLASH_SLOT_METADATA_ADDRESS) + index) != SUCCESS)
+        {
+          status = ERROR;
+        }
+      }
+
+      FlashActiveSlotSequence = 0U;
+      record_address          = FLASH_SLOT_METADATA_ADDRESS;
+    }
+    else
+    {
+      /* Append after the newest record, skipping the double words left by an interrupted program */
+      do
+      {
+        record_address += FLASH_PROG_STEP_SIZE;
+      } while (((record_address % FLASH_PAGE_SIZE) != 0U)
+               && ((*(__IO uint32_t *)record_address != 0xFFFFFFFFU)
+                   || (*(__IO uint32_t *)(record_address + 4U) != 0xFFFFFFFFU)));
+
+      if ((record_address % FLASH_PAGE_SIZE) == 0U)
+      {
+        /* The page is full, continue at the start of the other metadata page */
+        record_address = ((record_address - FLASH_PAGE_SIZE) == FLASH_SLOT_METADATA_ADDRESS) ?
+                         (FLASH_SLOT_METADATA_ADDRESS + FLASH_PAGE_SIZE) : FLASH_SLOT_METADATA_ADDRESS;
+
+        status = OPENBL_FLASH_ErasePage(FLASH_GET_PAGE(record_address));
+      }
+    }
+  }
+
+  if (status == SUCCESS)
+  {
+    record = ((uint64_t)(FLASH_SLOT_RECORD_MAGIC | Slot) << 32U) | (FlashActiveSlotSequence + 1U);
+
+    status = OPENBL_FLASH_ProgramRecord(record_address, record);
+  }
+
+  /* Read back the records to make sure the new one is the newest */
+  FlashSlotRecordsScanned = 0U;
+
+  if ((status == SUCCESS) && (OPENBL_FLASH_GetActiveSlot() != Slot))
+  {
+    status = ERROR;
+  }
+
+  return status;
+}
+
+/**
+  * @brief  This function is used to process the A/B slot special command.
+  *         Buffer1[0] = 0x00: get the slot status, the response data is 13 bytes, MSB first:
+  *         - 1 byte: the active slot, 0x00 for A, 0x01 for B or 0xFF when the A/B slot mode is not in use
+  *         - 4 bytes: the sequence number of the active slot record
+  *         - 4 bytes: the address of the slot where a new image must be written
+  *         - 4 bytes: the size of a slot
+  *         Buffer1[0] = 0x01: activate the slot given in Buffer1[1], there is no response data.
+  * @param  SpecialCmd Pointer to the OPENBL_SpecialCmdTypeDef structure.
+  * @param  SendByte The function used to send one byte through the detected interface.
+  * @retval None.
+  */
+void OPENBL_FLASH_SlotCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte)
+{
+  uint32_t active_slot;
+  uint32_t size        = 0U;
+  ErrorStatus status   = ERROR;
+
+  if ((SpecialCmd->SizeBuffer1 == 1U) && (SpecialCmd->Buffer1[0] == FLASH_SLOT_CMD_GET_STATUS))
+  {
+    size   = FLASH_SLOT_STATUS_SIZE;
+    status = SUCCESS;
+  }
+  else if ((SpecialCmd->SizeBuffer1 == 2U) && (SpecialCmd->Buffer1[0] == FLASH_SLOT_CMD_SET_ACTIVE))
+  {
+    status = OPENBL_FLASH_SetActiveSlot(SpecialCmd->Buffer1[1]);
+  }
+  else
+  {
+    /* Nothing to do, the command is not valid */
+  }
+
+  if (SpecialCmd->CmdType == OPENBL_SPECIAL_CMD)
+  {
+    Common_SendHalfWord(SendByte, (uint16_t)size);
+
+    if (size != 0U)
+    {
+      active_slot = OPENBL_FLASH_GetActiveSlot();
+
+      SendByte((uint8_t)active_slot);
+      Common_SendWord(SendByte, (active_slot == FLASH_SLOT_NONE) ? 0U : FlashActiveSlotSequence);
+      Common_SendWord(SendByte, (active_slot == FLASH_SLOT_A) ? FLASH_SLOT_B_ADDRESS : FLASH_SLOT_A_ADDRESS);
+      Common_SendWord(SendByte, FLASH_SLOT_SIZE);
+    }
+  }
+
+  Common_SendSpecialCmdStatus(SendByte, status);
+}
+
+/**
+  * @brief  This function is used to process the download journal special command.
+  *         The journal records the FLASH pages of a download that are programmed and verified, so that
+  *         the host continues from the first incomplete page after a reconnection or a reset.
+  *         Buffer1[0] = 0x00: start a new download, followed by the image identifier (4 bytes MSB first),
+  *         the first page and the number of pages (1 byte each). There is no response data.
+  *         Buffer1[0] = 0x01: verify a page and record it, followed by the page (1 byte) and the expected
+  *         CRC-32 of the page (4 bytes MSB first). There is no response data, the status is NACK if the
+  *         CRC does not match.
+  *         Buffer1[0] = 0x02: get the resume point, the response data is 8 bytes: the image identifier
+  *         (4 bytes MSB first), the first page, the number of pages, the first page not recorded and the
+  *         number of recorded pages (1 byte each). The number of pages is 0 if there is no download.
+  * @param  SpecialCmd Pointer to the OPENBL_SpecialCmdTypeDef structure.
+  * @param  SendByte The function used to send one byte through the detected interface.
+  * @retval None.
+  */
+void OPENBL_FLASH_JournalCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte)
+{
+  uint32_t page;
+  uint32_t resume_page;
+  uint32_t done_pages = 0U;
+  uint32_t size       = 0U;
+  ErrorStatus status  = ERROR;
+  FLASH_JournalTypeDef journal;
+
+  if ((SpecialCmd->SizeBuffer1 == 7U) && (SpecialCmd->Buffer1[0] == FLASH_JOURNAL_CMD_START))
+  {
+    status = OPENBL_FLASH_StartJournal(Common_GetWord(&SpecialCmd->Buffer1[1]), SpecialCmd->Buffer1[5],
+                                       SpecialCmd->Buffer1[6]);
+  }
+  else if ((SpecialCmd->SizeBuffer1 == 6U) && (SpecialCmd->Buffer1[0] == FLASH_JOURNAL_CMD_COMMIT_PAGE))
+  {
+    status = OPENBL_FLASH_CommitJournalPage(SpecialCmd->Buffer1[1], Common_GetWord(&SpecialCmd->Buffer1[2]));
+  }
+  else if ((SpecialCmd->SizeBuffer1 == 1U) && (SpecialCmd->Buffer1[0] == FLASH_JOURNAL_CMD_GET_RESUME))
+  {
+    size   = FLASH_JOURNAL_STATUS_SIZE;
+    status = SUCCESS;
+  }
+  else
+  {
+    /* Nothing to do, the command is not valid */
+  }
+
+  if (SpecialCmd->CmdType == OPENBL_SPECIAL_CMD)
+  {
+    Common_SendHalfWord(SendByte, (uint16_t)size);
+
+    if (size != 0U)
+    {
+      OPENBL_FLASH_ReadJournal(&journal);
+
+      resume_page = journal.FirstPage + journal.PagesNumber;
+
+      for (page = journal.FirstPage; page < (journal.FirstPage + journal.PagesNumber); page++)
+      {
+        if (FLASH_IS_PAGE_SET(journal.DonePages, page))
+        {
+          done_pages++;
+        }
+        else if (page < resume_page)
+        {
+          resume_page = page;
+        }
+        else
+        {
+          /* Nothing to do, the resume point is already found */
+        }
+      }
+
+      Common_SendWord(SendByte, journal.ImageId);
+      SendByte((uint8_t)journal.FirstPage);
+      SendByte((uint8_t)journal.PagesNumber);
+      SendByte((uint8_t)resume_page);
+      SendByte((uint8_t)done_pages);
+    }
+  }
+
+  Common_SendSpecialCmdStatus(SendByte, status);
+}
+
+/**
+  * @brief  This function is used to process the erase counters special command.
+  *         Buffer1 is empty. The response data is the erase counter of each FLASH page, 2 bytes MSB first,
+  *         from page 0. The counters saturate at 0xFFFF.
+  * @param  SpecialCmd Pointer to the OPENBL_SpecialCmdTypeDef structure.
+  * @param  SendByte The function used to send one byte through the detected interface.
+  * @retval None.
+  */
+void OPENBL_FLASH_WearCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte)
+{
+  uint32_t page;
+  uint32_t size      = 0U;
+  ErrorStatus status = ERROR;
+
+  if (SpecialCmd->SizeBuffer1 == 0U)
+  {
+    OPENBL_FLASH_LoadWearLog();
+
+    size   = FLASH_PAGE_NUMBER * 2U;
+    status = SUCCESS;
+  }
+
+  if (SpecialCmd->CmdType == OPENBL_SPECIAL_CMD)
+  {
+    Common_SendHalfWord(SendByte, (uint16_t)size);
+
+    for (page = 0U; page < (size / 2U); page++)
+    {
+      Common_SendHalfWord(SendByte, FlashWearCounters[page]);
+    }
+  }
+
+  Common_SendSpecialCmdStatus(SendByte, status);
+}
+
+/**
+  * @brief  This function is used to process the ECC scan special command.
+  *         Buffer1 contains the start address and the length of the FLASH range, 4 bytes each MSB first.
+  *         The range is read by double words and the ECC events are collected from the FLASH ECC register.
+  *         The response data is the number of ECC events (2 bytes MSB first) followed by the first 32 events,
+  *         the double word address (4 bytes MSB first) and the type (1 byte, 0x01 for a corrected single
+  *         error, 0x02 for an uncorrectable double error). The status is NACK if the range is not valid or
+  *         if the read protection is active.
+  * @param  SpecialCmd Pointer to the OPENBL_SpecialCmdTypeDef structure.
+  * @param  SendByte The function used to send one byte through the detected interface.
+  * @retval None.
+  */
+void OPENBL_FLASH_EccScanCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte)
+{
+  uint32_t index;
+  uint32_t address;
+  uint32_t end_address;
+  uint32_t length;
+  uint32_t events_number = 0U;
+  uint32_t events_address[FLASH_ECC_SCAN_MAX_EVENTS];
+  uint8_t events_type[FLASH_ECC_SCAN_MAX_EVENTS];
+  __IO uint32_t data;
+  ErrorStatus status     = ERROR;
+
+  /* The addresses of the ECC errors would tell what the Read memory command hides */
+  if ((SpecialCmd->SizeBuffer1 == 8U) && (Common_GetProtectionStatus() == RESET))
+  {
+    address = Common_GetWord(&SpecialCmd->Buffer1[0]);
+    length  = Common_GetWord(&SpecialCmd->Buffer1[4]);
+
+    if ((length != 0U) && (address >= FLASH_START_ADDRESS) && (address < FLASH_END_ADDRESS)
+        && (length <= (FLASH_END_ADDRESS - address)))
+    {
+      status = SUCCESS;
+    }
+  }
+
+  if (status == SUCCESS)
+  {
+    /* Scan the programmed content only */
+    OPENBL_FLASH_FlushWriteCache();
+    OPENBL_FLASH_WaitForPendingErase();
+
+    end_address = address + length;
+    address    -= (address % FLASH_PROG_STEP_SIZE);
+
+    __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ECCC | FLASH_FLAG_ECCD);
+
+    FlashEccDoubleError = 0U;
+    FlashEccScanOngoing = 1U;
+
+    for (; address < end_address; address += FLASH_PROG_STEP_SIZE)
+    {
+      /* Read the whole double word, the ECC is checked on the double word */
+      data = *(__IO uint32_t *)address;
+      data = *(__IO uint32_t *)(address + 4U);
+
+      if (FlashEccDoubleError != 0U)
+      {
+        if (events_number < FLASH_ECC_SCAN_MAX_EVENTS)
+        {
+          events_address[events_number] = FlashEccDoubleErrorAddress;
+          events_type[events_number]     = FLASH_ECC_UNCORRECTABLE;
+        }
+
+        events_number++;
+        FlashEccDoubleError = 0U;
+      }
+
+      if ((FLASH->ECCR & FLASH_ECCR_ECCC) != 0U)
+      {
+        if (events_number < FLASH_ECC_SCAN_MAX_EVENTS)
+        {
+          events_address[events_number] = FLASH_GET_ECC_ADDRESS();
+          events_type[events_number]     = FLASH_ECC_CORRECTED;
+        }
+
+        events_number++;
+        __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ECCC);
+      }
+
+      if ((address % FLASH_PAGE_SIZE) == 0U)
+      {
+        OPENBL_IWDG_Refresh();
+      }
+    }
+
+    FlashEccScanOngoing = 0U;
+
+    (void)data;
+  }
+
+  if (SpecialCmd->CmdType == OPENBL_SPECIAL_CMD)
+  {
+    if (status == SUCCESS)
+    {
+      length = (events_number > FLASH_ECC_SCAN_MAX_EVENTS) ? FLASH_ECC_SCAN_MAX_EVENTS : events_number;
+
+      Common_SendHalfWord(SendByte, (uint16_t)(2U + (length * FLASH_ECC_EVENT_SIZE)));
+      Common_SendHalfWord(SendByte, (uint16_t)events_number);
+
+      for (index = 0U; index < length; index++)
+      {
+        Common_SendWord(SendByte, events_address[index]);
+        SendByte(events_type[index]);
+      }
+    }
+    else
+    {
+      /* Send NULL data size */
+      Common_SendHalfWord(SendByte, 0U);
+    }
+  }
+
+  Common_SendSpecialCmdStatus(SendByte, status);
+}
+
+/**
+  * @brief  Handle the FLASH ECC double error NMI.
+  * @note   During the ECC scan, the error is recorded and cleared so that the scan goes on.
+  * @retval An ErrorStatus enumeration value:
+  *          - SUCCESS: The NMI is handled
+  *          - ERROR:   The NMI is not caused by the ECC scan
+  */
+ErrorStatus OPENBL_FLASH_NMIHandler(void)
+{
+  ErrorStatus status = ERROR;
+
+  if ((FlashEccScanOngoing != 0U) && ((FLASH->ECCR & FLASH_ECCR_ECCD) != 0U))
+  {
+    FlashEccDoubleErrorAddress = FLASH_GET_ECC_ADDRESS();
+    FlashEccDoubleError        = 1U;
+
+    __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ECCD);
+
+    status = SUCCESS;
+  }
+
+  return status;
+}
+
+/**
+  * @brief  Handle FLASH interrupt request.
+  * @retval None.
+  */
+void OPENBL_FLASH_IRQHandler(void)
+{
+  /* The end of a double word programming is handled by the programming engine, the erase by the HAL */
+  if (OPENBL_PROG_IRQHandler() != SUCCESS)
+  {
+    HAL_FLASH_IRQHandler();
+  }
+
+  /* The HAL FLASH process is unlocked only once its handler returns, so the next page is started here */
+  OPENBL_FLASH_StartNextErase();
+}
+
+/**
+  * @brief  FLASH end of operation interrupt callback.
+  * @param  ReturnValue The page that has been erased.
+  * @retval None.
+  */
+void HAL_FLASH_EndOfOperationCallback(uint32_t ReturnValue)
+{
+  OPENBL_FLASH_ErasePageDone(SUCCESS);
+}
+
+/**
+  * @brief  FLASH operation error interrupt callback.
+  * @param  ReturnValue The page that failed to be erased.
+  * @retval None.
+  */
+void HAL_FLASH_OperationErrorCallback(uint32_t ReturnValue)
+{
+  OPENBL_FLASH_ErasePageDone(ERROR);
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Program double word at a specified FLASH address.
+  * @note   The double word is queued to the programming engine, a programming error is reported
+  *         by OPENBL_FLASH_GetWriteStatus().
+  * @param  Address specifies the address to be programmed.
+  * @param  Data specifies the data to be programmed.
+  * @retval An ErrorStatus enumeration value:
+  *          - SUCCESS: The double word is queued
+  *          - ERROR:   The page of the double word is locked
+  */
+static ErrorStatus OPENBL_FLASH_Program(uint32_t Address, uint64_t Data)
+{
+  ErrorStatus status = SUCCESS;
+
+  if (OPENBL_FLASH_IsPageWritable(FLASH_GET_PAGE(Address)) != SUCCESS)
+  {
+    status = ERROR;
+  }
+  else
+  {
+    OPENBL_PROG_Submit(Address, Data);
+
+    /* The host may write slot records itself when the A/B slot mode is not in use */
+    if (FLASH_IS_SLOT_METADATA(Address))
+    {
+      FlashSlotRecordsScanned = 0U;
+    }
+  }
+
+  return status;
+}
+
+/**
+  * @brief  Add a page to the background erase queue.
+  * @param  Page The page to be erased.
+  * @retval An ErrorStatus enumeration value:
+  *          - SUCCESS: The page is queued or is already waiting to be erased
+  *          - ERROR:   The page number is not valid
+  */
+static ErrorStatus OPENBL_FLASH_QueuePageErase(uint32_t Page)
+{
+  ErrorStatus status = SUCCESS;
+
+  if (Page >= FLASH_PAGE_NUMBER)
+  {
+    status = ERROR;
+  }
+  else if (FLASH_IS_PAGE_PENDING(Page) == 0U)
+  {
+    /* The erase record is only reserved here, it is programmed by the FLASH interrupt after the erase */
+    OPENBL_FLASH_AddPageErase(Page, OPENBL_FLASH_ReserveWearRecord(Page));
+  }
+  else
+  {
+    /* Nothing to do, the page is already waiting to be erased */
+  }
+
+  return status;
+}
+
+/**
+  * @brief  Add a page at the tail of the background erase queue.
+  * @note   A page is queued only once, so the queue can never overflow.
+  * @param  Page The page to be erased, it must not be waiting to be erased already.
+  * @param  Record 1 if an erase record is reserved for the page, 0 otherwise.
+  * @retval None.
+  */
+static void OPENBL_FLASH_AddPageErase(uint32_t Page, uint32_t Record)
+{
+  uint32_t primask = Common_SaveDisableIrq();
+
+  FlashEraseQueue[(FlashEraseQueueHead + FlashEraseQueueCount) % FLASH_ERASE_QUEUE_SIZE] = (uint8_t)Page;
+  FlashEraseQueueCount++;
+  FlashErasePendingPages[Page >> 5U] |= (1UL << (Page & 0x1FU));
+  FlashErasedPages[Page >> 5U]       |= (1UL << (Page & 0x1FU));
+
+  if (Record != 0U)
+  {
+    FlashWearRecordPages[Page >> 5U] |= (1UL << (Page & 0x1FU));
+  }
+
+  if (FLASH_IS_SLOT_METADATA(FLASH_START_ADDRESS + (Page * FLASH_PAGE_SIZE)))
+  {
+    FlashSlotRecordsScanned = 0U;
+  }
+
+  Common_RestoreIrq(primask);
+}
+
+/**
+  * @brief  Start the erase of the page at the head of the queue.
+  * @note   Called from thread mode when the queue is idle and from the FLASH interrupt when a page
+  *         erase or a double word programming completes, it does nothing if an erase is ongoing,
+  *         if the erase is suspended or if the programming engine is busy. The erase record of the
+  *         previous page is programmed first.
+  * @retval None.
+  */
+static void OPENBL_FLASH_StartNextErase(void)
+{
+  FLASH_EraseInitTypeDef erase_init_struct;
+
+  OPENBL_FLASH_SubmitWearRecord();
+
+  while ((FlashEraseOngoing == 0U) && (FlashEraseSuspended == 0U) && (FlashEraseQueueCount != 0U)
+         && (OPENBL_PROG_IsBusy() == 0U))
+  {
+    erase_init_struct.TypeErase = FLASH_TYPEERASE_PAGES;
+    erase_init_struct.Page      = FlashEraseQueue[FlashEraseQueueHead];
+    erase_init_struct.NbPages   = 1U;
+
+    OPENBL_FLASH_Unlock();
+
+    /* Clear error programming flags */
+    __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+
+    FlashEraseOngoing = 1U;
+
+    if (HAL_FLASHEx_Erase_IT(&erase_init_struct) != HAL_OK)
+    {
+      /* Drop this page and try the next one */
+      OPENBL_FLASH_ErasePageDone(ERROR);
+
+      OPENBL_FLASH_SubmitWearRecord();
+    }
+  }
+
+  /* Lock the Flash once the queue is empty, unless a write operation is ongoing */
+  if ((FlashEraseOngoing == 0U) && (FlashEraseSuspended == 0U) && (FlashEraseQueueCount == 0U)
+      && (OPENBL_PROG_IsBusy() == 0U))
+  {
+    OPENBL_FLASH_Lock();
+  }
+}
+
+/**
+  * @brief  Queue the erase of all the pages except the wear log pages, the erase queue must be empty.
+  * @note   The pages are erased one by one by the background erase instead of a hardware mass erase,
+  *         which would also clear the wear log. A single erase record counts the mass erase, it is
+  *         programmed after the erase of the last page.
+  * @retval None.
+  */
+static void OPENBL_FLASH_StartMassErase(void)
+{
+  uint32_t page;
+  uint32_t record;
+
+  /* Reserved before the pages are queued, so that a compaction of the wear log does not wait for them */
+  record = OPENBL_FLASH_ReserveWearRecord(FLASH_WEAR_ALL_PAGES);
+
+  FlashMassEraseOngoing = record;
+  FlashEraseStartTick   = HAL_GetTick();
+
+  for (page = 0U; page < FLASH_PAGE_NUMBER; page++)
+  {
+    if (FLASH_IS_WEAR_LOG(FLASH_START_ADDRESS + (page * FLASH_PAGE_SIZE)) == 0U)
+    {
+      OPENBL_FLASH_AddPageErase(page, (page == (FLASH_PAGE_NUMBER - 1U)) ? record : 0U);
+    }
+  }
+
+  OPENBL_SIGN_Invalidate(FLASH_START_ADDRESS, FLASH_BL_SIZE);
+
+  OPENBL_FLASH_StartNextErase();
+}
+
+/**
+  * @brief  Return the number of pages waiting to be erased.
+  * @retval The number of pages.
+  */
+static uint32_t OPENBL_FLASH_GetPendingPagesNumber(void)
+{
+  uint32_t page;
+  uint32_t pages_number = 0U;
+
+  for (page = 0U; page < FLASH_PAGE_NUMBER; page++)
+  {
+    if (FLASH_IS_PAGE_PENDING(page))
+    {
+      pages_number++;
+    }
+  }
+
+  return pages_number;
+}
+
+/**
+  * @brief  Get the pages protected by the write protection areas A and B.
+  * @param  pPages Bitmap of the FLASH pages, the protected pages are set.
+  * @retval None.
+  */
+static void OPENBL_FLASH_GetWriteProtectedPages(uint32_t *pPages)
+{
+  uint32_t area;
+  uint32_t page;
+  FLASH_OBProgramInitTypeDef flash_ob;
+
+  for (area = 0U; area < 2U; area++)
+  {
+    flash_ob.WRPArea = (area == 0U) ? OB_WRPAREA_BANK1_AREAA : OB_WRPAREA_BANK1_AREAB;
+
+    HAL_FLASHEx_OBGetConfig(&flash_ob);
+
+    /* The area is disabled when its start offset is higher than its end offset */
+    for (page = flash_ob.WRPStartOffset; (page <= flash_ob.WRPEndOffset) && (page < FLASH_PAGE_NUMBER); page++)
+    {
+      pPages[page >> 5U] |= (1UL << (page & 0x1FU));
+    }
+  }
+}
+
+/**
+  * @brief  Find the newest valid slot record.
+  * @note   A record is a double word: the sequence number, then the record magic with the slot number
+  *         in the lowest byte. Erased and partially programmed double words are not valid.
+  * @param  pRecordAddress The address of the newest record, not modified if there is no valid record.
+  * @retval The slot of the newest record, or FLASH_SLOT_NONE if there is no valid record.
+  */
+static uint32_t OPENBL_FLASH_ScanSlotRecords(uint32_t *pRecordAddress)
+{
+  uint32_t address;
+  uint32_t sequence;
+  uint32_t record;
+  uint32_t slot = FLASH_SLOT_NONE;
+
+  OPENBL_FLASH_WaitForPageErase(FLASH_GET_PAGE(FLASH_SLOT_METADATA_ADDRESS));
+  OPENBL_FLASH_WaitForPageErase(FLASH_GET_PAGE(FLASH_SLOT_METADATA_ADDRESS) + 1U);
+
+  for (address = FLASH_SLOT_METADATA_ADDRESS; address < (FLASH_SLOT_METADATA_ADDRESS + FLASH_SLOT_METADATA_SIZE);
+       address += FLASH_PROG_STEP_SIZE)
+  {
+    sequence = *(__IO uint32_t *)address;
+    record   = *(__IO uint32_t *)(address + 4U);
+
+    if (((record & FLASH_SLOT_RECORD_MAGIC_MASK) == FLASH_SLOT_RECORD_MAGIC)
+        && ((record & ~FLASH_SLOT_RECORD_MAGIC_MASK) <= FLASH_SLOT_B) && (sequence != 0xFFFFFFFFU)
+        && ((slot == FLASH_SLOT_NONE) || (sequence > FlashActiveSlotSequence)))
+    {
+      slot                    = record & ~FLASH_SLOT_RECORD_MAGIC_MASK;
+      FlashActiveSlotSequence = sequence;
+      *pRecordAddress         = address;
+    }
+  }
+
+  return slot;
+}
+
+/**
+  * @brief  Erase a FLASH page and wait for the end of the operation.
+  * @param  Page The page to be erased.
+  * @retval An ErrorStatus enumeration value:
+  *          - SUCCESS: The page is erased
+  *          - ERROR:   The page failed to be erased
+  */
+static ErrorStatus OPENBL_FLASH_ErasePage(uint32_t Page)
+{
+  ErrorStatus status = SUCCESS;
+
+  if (OPENBL_FLASH_QueuePageErase(Page) != SUCCESS)
+  {
+    status = ERROR;
+  }
+  else
+  {
+    OPENBL_FLASH_StartNextErase();
+    OPENBL_FLASH_WaitForPageErase(Page);
+
+    /* A failed page erase clears the erased state of the page */
+    if (FLASH_IS_PAGE_ERASED(Page) == 0U)
+    {
+      status = ERROR;
+    }
+  }
+
+  return status;
+}
+
+/**
+  * @brief  Program a record double word in a metadata page.
+  * @note   The erase is kept suspended if the caller suspended it.
+  * @param  Address The address of the record, the double word must be erased.
+  * @param  Record The record to be programmed.
+  * @retval An ErrorStatus enumeration value:
+  *          - SUCCESS: The record is programmed
+  *          - ERROR:   The programming operation failed
+  */
+static ErrorStatus OPENBL_FLASH_ProgramRecord(uint32_t Address, uint64_t Record)
+{
+  uint32_t suspended = FlashEraseSuspended;
+  ErrorStatus status;
+
+  OPENBL_FLASH_SuspendErase();
+  OPENBL_FLASH_Unlock();
+
+  /* Keep the errors of the data written before for the host */
+  OPENBL_FLASH_WaitForProgram();
+
+  OPENBL_PROG_Submit(Address, Record);
+
+  status = OPENBL_PROG_WaitForCompletion();
+
+  /* Records are also added while a write operation holds the erase */
+  if (suspended == 0U)
+  {
+    OPENBL_FLASH_ResumeErase();
+  }
+
+  return status;
+}
+
+/**
+  * @brief  Read the current download from the journal records.
+  * @note   A download starts with a start record at the beginning of a journal page: the image identifier,
+  *         then the start magic, an 8-bit sequence number, the first page and the number of pages. It
+  *         is followed by page records: the CRC-32 of the page, then the page magic with the page number
+  *         in the lowest byte. The newest start record gives the current journal page.
+  * @param  pJournal The current download, PageAddress is 0 if there is none.
+  * @retval None.
+  */
+static void OPENBL_FLASH_ReadJournal(FLASH_JournalTypeDef *pJournal)
+{
+  uint32_t index;
+  uint32_t address;
+  uint32_t record;
+  uint32_t sequence;
+  uint32_t first_page;
+  uint32_t pages_number;
+
+  pJournal->PageAddress = 0U;
+  pJournal->FreeAddress = 0U;
+  pJournal->Sequence    = 0U;
+  pJournal->ImageId     = 0U;
+  pJournal->FirstPage   = 0U;
+  pJournal->PagesNumber = 0U;
+
+  for (index = 0U; index < (FLASH_PAGE_NUMBER / 32U); index++)
+  {
+    pJournal->DonePages[index] = 0U;
+  }
+
+  for (address = FLASH_JOURNAL_ADDRESS; address < (FLASH_JOURNAL_ADDRESS + FLASH_JOURNAL_SIZE); address += FLASH_PAGE_SIZE)
+  {
+    OPENBL_FLASH_WaitForPageErase(FLASH_GET_PAGE(address));
+
+    record       = *(__IO uint32_t *)(address + 4U);
+    sequence     = (record >> 16U) & 0xFFU;
+    first_page   = (record >> 8U) & 0xFFU;
+    pages_number = record & 0xFFU;
+
+    /* The sequence number wraps around, the newest start record is at most 127 downloads ahead */
+    if (((record >> 24U) == FLASH_JOURNAL_START_MAGIC) && (pages_number != 0U)
+        && ((first_page + pages_number) <= FLASH_PAGE_NUMBER)
+        && ((pJournal->PageAddress == 0U) || (((sequence - pJournal->Sequence) & 0xFFU) < 0x80U)))
+    {
+      pJournal->PageAddress = address;
+      pJournal->Sequence    = sequence;
+      pJournal->ImageId     = *(__IO uint32_t *)address;
+      pJournal->FirstPage   = first_page;
+      pJournal->PagesNumber = pages_number;
+    }
+  }
+
+  if (pJournal->PageAddress != 0U)
+  {
+    for (address = pJournal->PageAddress + FLASH_PROG_STEP_SIZE; address < (pJournal->PageAddress + FLASH_PAGE_SIZE);
+         address += FLASH_PROG_STEP_SIZE)
+    {
+      record = *(__IO uint32_t *)(address + 4U);
+
+      if (((record & FLASH_JOURNAL_PAGE_MAGIC_MASK) == FLASH_JOURNAL_PAGE_MAGIC) && ((record & 0xFFU) < FLASH_PAGE_NUMBER))
+      {
+        pJournal->DonePages[(record & 0xFFU) >> 5U] |= (1UL << (record & 0x1FU));
+      }
+      else if ((pJournal->FreeAddress == 0U) && (record == 0xFFFFFFFFU) && (*(__IO uint32_t *)address == 0xFFFFFFFFU))
+      {
+        pJournal->FreeAddress = address;
+      }
+      else
+      {
+        /* Double word left by an interrupted program */
+      }
+    }
+  }
+}
+
+/**
+  * @brief  Start a new download in the journal.
+  * @note   The new start record is written in the other journal page, the journal page of the previous
+  *         download is then erased in background. So a power loss keeps one of the two downloads.
+  * @param  ImageId The image identifier given by the host.
+  * @param  FirstPage The first FLASH page of the download.
+  * @param  PagesNumber The number of FLASH pages of the download.
+  * @retval An ErrorStatus enumeration value:
+  *          - SUCCESS: The download is started
+  *          - ERROR:   The pages are not valid or the journal failed to be updated
+  */
+static ErrorStatus OPENBL_FLASH_StartJournal(uint32_t ImageId, uint32_t FirstPage, uint32_t PagesNumber)
+{
+  uint32_t page_address;
+  uint64_t record;
+  ErrorStatus status = SUCCESS;
+  FLASH_JournalTypeDef journal;
+
+  if ((PagesNumber == 0U) || ((FirstPage + PagesNumber) > FLASH_PAGE_NUMBER))
+  {
+    status = ERROR;
+  }
+  else
+  {
+    OPENBL_FLASH_ReadJournal(&journal);
+
+    page_address = (journal.PageAddress == FLASH_JOURNAL_ADDRESS) ? (FLASH_JOURNAL_ADDRESS + FLASH_PAGE_SIZE)
+                   : FLASH_JOURNAL_ADDRESS;
+
+    /* The page of the new start record must be blank */
+    if (OPENBL_FLASH_IsPageBlank(FLASH_GET_PAGE(page_address)) == 0U)
+    {
+      status = OPENBL_FLASH_ErasePage(FLASH_GET_PAGE(page_address));
+    }
+
+    if (status == SUCCESS)
+    {
+      record = ((uint64_t)(((uint32_t)FLASH_JOURNAL_START_MAGIC << 24U) | (((journal.Sequence + 1U) & 0xFFU) << 16U)
+                           | (FirstPage << 8U) | PagesNumber) << 32U) | ImageId;
+
+      status = OPENBL_FLASH_ProgramRecord(page_address, record);
+    }
+
+    if ((status == SUCCESS) && (journal.PageAddress != 0U))
+    {
+      (void)OPENBL_FLASH_QueuePageErase(FLASH_GET_PAGE(journal.PageAddress));
+
+      OPENBL_FLASH_StartNextErase();
+    }
+  }
+
+  return status;
+}
+
+/**
+  * @brief  Verify a FLASH page of the current download and record it in the journal.
+  * @param  Page The FLASH page to be recorded.
+  * @param  Crc The expected CRC-32 of the page.
+  * @retval An ErrorStatus enumeration value:
+  *          - SUCCESS: The page is recorded
+  *          - ERROR:   The page is not part of the download, its CRC does not match, a programming error
+  *                     is pending or the journal is full
+  */
+static ErrorStatus OPENBL_FLASH_CommitJournalPage(uint32_t Page, uint32_t Crc)
+{
+  uint32_t page_address = FLASH_START_ADDRESS + (Page * FLASH_PAGE_SIZE);
+  ErrorStatus status    = SUCCESS;
+  FLASH_JournalTypeDef journal;
+
+  OPENBL_FLASH_ReadJournal(&journal);
+
+  if ((journal.PageAddress == 0U) || (Page < journal.FirstPage) || (Page >= (journal.FirstPage + journal.PagesNumber)))
+  {
+    status = ERROR;
+  }
+  else
+  {
+    /* The page must be fully programmed */
+    OPENBL_FLASH_FlushWriteCache();
+    OPENBL_FLASH_WaitForPageErase(Page);
+
+    if ((FlashWriteErrors != 0U) || (OPENBL_CRC_Calculate(page_address, FLASH_PAGE_SIZE) != Crc))
+    {
+      status = ERROR;
+    }
+    else if (FLASH_IS_PAGE_SET(journal.DonePages, Page))
+    {
+      /* Nothing to do, the page is already recorded */
+    }
+    else if (journal.FreeAddress == 0U)
+    {
+      status = ERROR;
+    }
+    else
+    {
+      status = OPENBL_FLASH_ProgramRecord(journal.FreeAddress, ((uint64_t)(FLASH_JOURNAL_PAGE_MAGIC | Page) << 32U) | Crc);
+    }
+  }
+
+  return status;
+}
+
+/**
+  * @brief  Check if a FLASH page is erased.
+  * @param  Page The page to be checked.
+  * @retval 1 if all the words of the page are erased, 0 otherwise.
+  */
+static uint32_t OPENBL_FLASH_IsPageBlank(uint32_t Page)
+{
+  uint32_t address = FLASH_START_ADDRESS + (Page * FLASH_PAGE_SIZE);
+  uint32_t blank   = 1U;
+
+  OPENBL_FLASH_WaitForPageErase(Page);
+
+  while ((blank != 0U) && (address < (FLASH_START_ADDRESS + ((Page + 1U) * FLASH_PAGE_SIZE))))
+  {
+    if (*(__IO uint32_t *)address != 0xFFFFFFFFU)
+    {
+      blank = 0U;
+    }
+
+    address += 4U;
+  }
+
+  return blank;
+}
+
+/**
+  * @brief  Increment the erase counter of a page, the counters saturate.
+  * @param  Page The erased page, or FLASH_WEAR_ALL_PAGES for all the pages but the wear log pages.
+  * @retval None.
+  */
+static void OPENBL_FLASH_IncrementWearCounter(uint32_t Page)
+{
+  uint32_t index;
+
+  for (index = 0U; index < FLASH_PAGE_NUMBER; index++)
+  {
+    if (((index == Page) || ((Page == FLASH_WEAR_ALL_PAGES)
+                             && (FLASH_IS_WEAR_LOG(FLASH_START_ADDRESS + (index * FLASH_PAGE_SIZE)) == 0U)))
+        && (FlashWearCounters[index] < FLASH_WEAR_COUNTER_MAX))
+    {
+      FlashWearCounters[index]++;
+    }
+  }
+}
+
+/**
+  * @brief  Load the erase counters from the wear log.
+  * @note   A wear log page starts with a header, the wear log magic and an 8-bit sequence number, followed
+  *         by one counter record per page, the counter then the counter magic and the page number. The
+  *         header is programmed last, so a page is only used once its counters are all programmed. The
+  *         next double words are erase records, one per page erase with the erase magic and the page
+  *         number, or FLASH_WEAR_ALL_PAGES for a mass erase, which does not erase the wear log pages.
+  *         The newest header gives the current page.
+  * @retval None.
+  */
+static void OPENBL_FLASH_LoadWearLog(void)
+{
+  uint32_t index;
+  uint32_t address;
+  uint32_t record;
+  uint32_t sequence;
+
+  if (FlashWearLoaded == 0U)
+  {
+    FlashWearLogAddress  = 0U;
+    FlashWearFreeAddress = 0U;
+
+    for (address = FLASH_WEAR_LOG_ADDRESS; address < (FLASH_WEAR_LOG_ADDRESS + FLASH_WEAR_LOG_SIZE);
+         address += FLASH_PAGE_SIZE)
+    {
+      OPENBL_FLASH_WaitForPageErase(FLASH_GET_PAGE(address));
+
+      record   = *(__IO uint32_t *)(address + 4U);
+      sequence = record & 0xFFU;
+
+      if (((record & FLASH_WEAR_MAGIC_MASK) == FLASH_WEAR_HEADER_MAGIC)
+          && ((FlashWearLogAddress == 0U) || (((sequence - FlashWearSequence) & 0xFFU) < 0x80U)))
+      {
+        FlashWearLogAddress = address;
+        FlashWearSequence   = sequence;
+      }
+    }
+
+    for (index = 0U; index < FLASH_PAGE_NUMBER; index++)
+    {
+      FlashWearCounters[index] = 0U;
+
+      if (FlashWearLogAddress != 0U)
+      {
+        address = FlashWearLogAddress + ((index + 1U) * FLASH_PROG_STEP_SIZE);
+
+        if (*(__IO uint32_t *)(address + 4U) == (FLASH_WEAR_COUNTER_MAGIC | index))
+        {
+          record = *(__IO uint32_t *)address;
+
+          FlashWearCounters[index] = (record > FLASH_WEAR_COUNTER_MAX) ? FLASH_WEAR_COUNTER_MAX : (uint16_t)record;
+        }
+      }
+    }
+
+    if (FlashWearLogAddress != 0U)
+    {
+      for (address = FlashWearLogAddress + ((FLASH_PAGE_NUMBER + 1U) * FLASH_PROG_STEP_SIZE);
+           address < (FlashWearLogAddress + FLASH_PAGE_SIZE); address += FLASH_PROG_STEP_SIZE)
+      {
+        record = *(__IO uint32_t *)(address + 4U);
+
+        if (((record & FLASH_WEAR_MAGIC_MASK) == FLASH_WEAR_ERASE_MAGIC)
+            && (((record & 0xFFU) < FLASH_PAGE_NUMBER) || ((record & 0xFFU) == FLASH_WEAR_ALL_PAGES)))
+        {
+          OPENBL_FLASH_IncrementWearCounter(record & 0xFFU);
+        }
+        else if ((FlashWearFreeAddress == 0U) && (record == 0xFFFFFFFFU) && (*(__IO uint32_t *)address == 0xFFFFFFFFU))
+        {
+          FlashWearFreeAddress = address;
+        }
+        else
+        {
+          /* Double word left by an interrupted program */
+        }
+      }
+    }
+
+    FlashWearLoaded = 1U;
+  }
+}
+
+/**
+  * @brief  Count the erase of a page and reserve its erase record in the wear log.
+  * @note   The wear log is compacted in the other wear log page when no record is left, the new counters
+  *         then include this erase and no record is reserved. The compaction waits for the queued erases.
+  * @param  Page The page to be erased, or FLASH_WEAR_ALL_PAGES for a mass erase.
+  * @retval 1 if an erase record is reserved, 0 otherwise.
+  */
+static uint32_t OPENBL_FLASH_ReserveWearRecord(uint32_t Page)
+{
+  uint32_t primask;
+  uint32_t reserved = 0U;
+
+  /* The erase of the wear log page during its compaction is counted in the new counter records */
+  if (FlashWearCompacting != 0U)
+  {
+    OPENBL_FLASH_IncrementWearCounter(Page);
+  }
+  else
+  {
+    OPENBL_FLASH_LoadWearLog();
+
+    OPENBL_FLASH_IncrementWearCounter(Page);
+
+    /* The records of the erases already queued are programmed by the FLASH interrupt meanwhile */
+    primask = Common_SaveDisableIrq();
+
+    if ((FlashWearLogAddress != 0U) && (FlashWearFreeAddress != 0U)
+        && ((FlashWearFreeAddress + ((FlashWearReservedRecords + 1U) * FLASH_PROG_STEP_SIZE))
+            <= (FlashWearLogAddress + FLASH_PAGE_SIZE)))
+    {
+      FlashWearReservedRecords++;
+      reserved = 1U;
+    }
+
+    Common_RestoreIrq(primask);
+
+    if (reserved == 0U)
+    {
+      OPENBL_FLASH_CompactWearLog();
+    }
+  }
+
+  return reserved;
+}
+
+/**
+  * @brief  Queue the erase record of the last erased page to the programming engine.
+  * @note   Called when the erase and the programming engine are idle, so that the record is programmed
+  *         before the next page erase starts. It waits while the erase is held by a write operation.
+  * @retval None.
+  */
+static void OPENBL_FLASH_SubmitWearRecord(void)
+{
+  if ((FlashWearRecord != 0U) && (FlashEraseSuspended == 0U))
+  {
+    OPENBL_FLASH_Unlock();
+
+    OPENBL_PROG_Submit(FlashWearFreeAddress, ((uint64_t)FlashWearRecord << 32U));
+
+    FlashWearFreeAddress += FLASH_PROG_STEP_SIZE;
+    FlashWearReservedRecords--;
+    FlashWearRecord = 0U;
+  }
+}
+
+/**
+  * @brief  Write the erase counters in the other wear log page.
+  * @note   The previous wear log page stays valid until the header of the new one is programmed.
+  *         If the erase was suspended by the caller, it is suspended again and the flash is left
+  *         unlocked on return.
+  * @retval None.
+  */
+static void OPENBL_FLASH_CompactWearLog(void)
+{
+  uint32_t index;
+  uint32_t page_address;
+  uint32_t suspended = FlashEraseSuspended;
+  ErrorStatus status = SUCCESS;
+
+  FlashWearCompacting = 1U;
+
+  /* The reserved erase records are programmed before the counters are written again */
+  OPENBL_FLASH_WaitForPendingErase();
+
+  page_address = (FlashWearLogAddress == FLASH_WEAR_LOG_ADDRESS) ? (FLASH_WEAR_LOG_ADDRESS + FLASH_PAGE_SIZE)
+                 : FLASH_WEAR_LOG_ADDRESS;
+
+  if (OPENBL_FLASH_IsPageBlank(FLASH_GET_PAGE(page_address)) == 0U)
+  {
+    status = OPENBL_FLASH_ErasePage(FLASH_GET_PAGE(page_address));
+  }
+
+  for (index = 0U; (index < FLASH_PAGE_NUMBER) && (status == SUCCESS); index++)
+  {
+    status = OPENBL_FLASH_ProgramRecord(page_address + ((index + 1U) * FLASH_PROG_STEP_SIZE),
+                                        ((uint64_t)(FLASH_WEAR_COUNTER_MAGIC | index) << 32U) | FlashWearCounters[index]);
+  }
+
+  if (status == SUCCESS)
+  {
+    status = OPENBL_FLASH_ProgramRecord(page_address,
+                                        (uint64_t)(FLASH_WEAR_HEADER_MAGIC | ((FlashWearSequence + 1U) & 0xFFU)) << 32U);
+  }
+
+  if (status == SUCCESS)
+  {
+    FlashWearSequence        = (FlashWearSequence + 1U) & 0xFFU;
+    FlashWearReservedRecords = 0U;
+    FlashWearLogAddress      = page_address;
+    FlashWearFreeAddress     = page_address + ((FLASH_PAGE_NUMBER + 1U) * FLASH_PROG_STEP_SIZE);
+  }
+
+  if (suspended != 0U)
+  {
+    OPENBL_FLASH_SuspendErase();
+    OPENBL_FLASH_Unlock();
+  }
+
+  FlashWearCompacting = 0U;
+}
+
+/**
+  * @brief  Check that the host can erase or program a FLASH page.
+  * @note   The journal and wear log pages are always locked. In A/B slot mode, the pages of the active slot and of
+  *         the slot records are locked too.
+  * @param  Page The page to be checked.
+  * @retval An ErrorStatus enumeration value:
+  *          - SUCCESS: The page can be modified
+  *          - ERROR:   The page is locked
+  */
+static ErrorStatus OPENBL_FLASH_IsPageWritable(uint32_t Page)
+{
+  uint32_t address   = FLASH_START_ADDRESS + (Page * FLASH_PAGE_SIZE);
+  uint32_t slot      = OPENBL_FLASH_GetActiveSlot();
+  ErrorStatus status = SUCCESS;
+
+  if (FLASH_IS_JOURNAL(address) || FLASH_IS_WEAR_LOG(address))
+  {
+    status = ERROR;
+  }
+  else if (slot != FLASH_SLOT_NONE)
+  {
+    if (FLASH_IS_SLOT_METADATA(address)
+        || ((address >= FLASH_GET_SLOT_ADDRESS(slot)) && (address < (FLASH_GET_SLOT_ADDRESS(slot) + FLASH_SLOT_SIZE))))
+    {
+      status = ERROR;
+    }
+  }
+
+  return status;
+}
+
+/**
+  * @brief  Remove the page at the head of the queue once its erase operation is completed.
+  * @note   The erase record reserved for the page is left to OPENBL_FLASH_SubmitWearRecord(), the
+  *         programming can not be started from the HAL FLASH interrupt callbacks.
+  * @param  Status The status of the erase operation.
+  * @retval None.
+  */
+static void OPENBL_FLASH_ErasePageDone(ErrorStatus Status)
+{
+  uint32_t page;
+
+  if (FlashEraseOngoing != 0U)
+  {
+    page = FlashEraseQueue[FlashEraseQueueHead];
+
+    if (Status != SUCCESS)
+    {
+      FlashEraseErrors++;
+
+      /* The page will be erased again by the erase on first write mode */
+      FlashErasedPages[page >> 5U] &= ~(1UL << (page & 0x1FU));
+    }
+
+    /* The last page of a mass erase carries the record of the whole mass erase */
+    if (FLASH_IS_PAGE_SET(FlashWearRecordPages, page))
+    {
+      FlashWearRecordPages[page >> 5U] &= ~(1UL << (page & 0x1FU));
+
+      FlashWearRecord       = FLASH_WEAR_ERASE_MAGIC | ((FlashMassEraseOngoing != 0U) ? FLASH_WEAR_ALL_PAGES : page);
+      FlashMassEraseOngoing = 0U;
+    }
+
+    FlashErasePendingPages[page >> 5U] &= ~(1UL << (page & 0x1FU));
+    FlashEraseQueueHead = (FlashEraseQueueHead + 1U) % FLASH_ERASE_QUEUE_SIZE;
+    FlashEraseQueueCount--;
+    FlashEraseOngoing = 0U;
+  }
+}
+
+/**
+  * @brief  Wait until the given page is erased if it is still in the erase queue.
+  * @note   The pages queued before this one are erased first. If the erase was suspended by
+  *         the caller, it is suspended again and the flash is left unlocked on return.
+  * @param  Page The page to be checked.
+  * @retval None.
+  */
+static void OPENBL_FLASH_WaitForPageErase(uint32_t Page)
+{
+  uint32_t suspended;
+
+  if ((Page < FLASH_PAGE_NUMBER) && FLASH_IS_PAGE_PENDING(Page))
+  {
+    suspended = FlashEraseSuspended;
+
+    OPENBL_FLASH_ResumeErase();
+
+    while (FLASH_IS_PAGE_PENDING(Page))
+    {
+      OPENBL_IWDG_Refresh();
+    }
+
+    if (suspended != 0U)
+    {
+      OPENBL_FLASH_SuspendErase();
+      OPENBL_FLASH_Unlock();
+    }
+  }
+}
+
+/**
+  * @brief  Make sure the page of the given address is erased before programming it.
+  * @note   In erase on first write mode, a page not erased yet is queued for erase first.
+  * @param  Address The address to be programmed.
+  * @retval None.
+  */
+static void OPENBL_FLASH_PrepareProgram(uint32_t Address)
+{
+  uint32_t page = FLASH_GET_PAGE(Address);
+
+  if (page < FLASH_PAGE_NUMBER)
+  {
+    if ((FlashEraseOnWrite == ENABLE) && (FLASH_IS_PAGE_ERASED(page) == 0U)
+        && (OPENBL_FLASH_IsPageWritable(page) == SUCCESS))
+    {
+      (void)OPENBL_FLASH_QueuePageErase(page);
+    }
+
+    OPENBL_FLASH_WaitForPageErase(page);
+  }
+}
+
+/**
+  * @brief  Program the cached double word, the caller must have suspended the erase and unlocked the FLASH.
+  * @retval None.
+  */
+static void OPENBL_FLASH_ProgramWriteCache(void)
+{
+  if (FlashWriteCacheCount != 0U)
+  {
+    OPENBL_FLASH_PrepareProgram(FlashWriteCacheAddress);
+
+    if (OPENBL_FLASH_Program(FlashWriteCacheAddress, (uint64_t)(*((uint64_t *)((uint32_t)FlashWriteCache)))) != SUCCESS)
+    {
+      FlashWriteErrors++;
+    }
+
+    FlashWriteCacheCount = 0U;
+  }
 }
 
 /**
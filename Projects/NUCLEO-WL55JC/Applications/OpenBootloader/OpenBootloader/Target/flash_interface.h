@@ -25,6 +25,7 @@ extern "C" {
 #endif
 
 /* Includes ------------------------------------------------------------------*/
+#include "openbl_core.h"
 #include "common_interface.h"
 
 /* Exported types ------------------------------------------------------------*/
@@ -33,6 +34,10 @@ extern "C" {
 #define FLASH_BUSY_STATE_DISABLED         ((uint32_t)0x0000DDDD)
 #define PROGRAM_TIMEOUT                   ((uint32_t)0x00FFFFFF)
 
+#define FLASH_SLOT_A                      0x00U  /* Application slot A */
+#define FLASH_SLOT_B                      0x01U  /* Application slot B */
+#define FLASH_SLOT_NONE                   0xFFU  /* A/B slot mode not in use */
+
 /* Exported macro ------------------------------------------------------------*/
 /* Exported functions ------------------------------------------------------- */
 void OPENBL_FLASH_JumpToAddress(uint32_t Address);
@@ -40,11 +45,34 @@ void OPENBL_FLASH_Lock(void);
 void OPENBL_FLASH_OB_Unlock(void);
 void OPENBL_FLASH_OB_Launch(void);
 uint8_t OPENBL_FLASH_Read(uint32_t Address);
+const uint8_t *OPENBL_FLASH_ReadBlock(uint32_t Address, uint8_t *pBuffer, uint32_t BufferSize, uint32_t *pLength);
 void OPENBL_FLASH_SetReadOutProtectionLevel(uint32_t Level);
 void OPENBL_FLASH_Write(uint32_t Address, uint8_t *Data, uint32_t DataLength);
+void OPENBL_FLASH_FlushWriteCache(void);
+void OPENBL_FLASH_FlushCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte);
+ErrorStatus OPENBL_FLASH_GetWriteStatus(void);
+uint32_t OPENBL_FLASH_GetWriteErrorCount(void);
+void OPENBL_FLASH_WaitForProgram(void);
 void OPENBL_FLASH_Unlock(void);
 ErrorStatus OPENBL_FLASH_MassErase(uint8_t *p_Data, uint32_t DataLength);
 ErrorStatus OPENBL_FLASH_Erase(uint8_t *p_Data, uint32_t DataLength);
+void OPENBL_FLASH_RangeEraseCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte);
+void OPENBL_FLASH_SuspendErase(void);
+void OPENBL_FLASH_ResumeErase(void);
+void OPENBL_FLASH_WaitForPendingErase(void);
+void OPENBL_FLASH_EraseStatusCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte);
+void OPENBL_FLASH_EccScanCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte);
+ErrorStatus OPENBL_FLASH_NMIHandler(void);
+void OPENBL_FLASH_IRQHandler(void);
+void OPENBL_FLASH_SetEraseOnWrite(FunctionalState State);
+void OPENBL_FLASH_EraseOnWriteCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte);
+uint32_t OPENBL_FLASH_GetPageDigest(uint32_t Page);
+void OPENBL_FLASH_PageDigestCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte);
+uint32_t OPENBL_FLASH_GetActiveSlot(void);
+ErrorStatus OPENBL_FLASH_SetActiveSlot(uint32_t Slot);
+void OPENBL_FLASH_JournalCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte);
+void OPENBL_FLASH_WearCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte);
+void OPENBL_FLASH_SlotCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte);
 ErrorStatus OPENBL_FLASH_SetWriteProtection(FunctionalState State, uint8_t *ListOfPages, uint32_t Length);
 
 uint32_t OPENBL_FLASH_GetReadOutProtectionLevel(void);
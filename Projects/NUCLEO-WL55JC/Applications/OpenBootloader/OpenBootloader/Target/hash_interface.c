@@ -0,0 +1,327 @@
+/**
+  ******************************************************************************
+  * @file    hash_interface.c
+  * @author  MCD Application Team
+  * @brief   Contains SHA-256 computation functions
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "platform.h"
+#include "openbl_core.h"
+#include "app_openbootloader.h"
+#include "common_interface.h"
+#include "hash_interface.h"
+#include "iwdg_interface.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+#define HASH_BLOCK_SIZE                   64U  /* Size of a SHA-256 block */
+#define HASH_CHUNK_SIZE                   (4U * 1024U)  /* Bytes hashed between two watchdog refreshes */
+
+/* Private macro -------------------------------------------------------------*/
+#define HASH_ROTR(X, N)                   (((X) >> (N)) | ((X) << (32U - (N))))
+
+/* Private variables ---------------------------------------------------------*/
+static const uint32_t HashRoundConstants[64] =
+{
+  0x428A2F98U, 0x71374491U, 0xB5C0FBCFU, 0xE9B5DBA5U, 0x3956C25BU, 0x59F111F1U, 0x923F82A4U, 0xAB1C5ED5U,
+  0xD807AA98U, 0x12835B01U, 0x243185BEU, 0x550C7DC3U, 0x72BE5D74U, 0x80DEB1FEU, 0x9BDC06A7U, 0xC19BF174U,
+  0xE49B69C1U, 0xEFBE4786U, 0x0FC19DC6U, 0x240CA1CCU, 0x2DE92C6FU, 0x4A7484AAU, 0x5CB0A9DCU, 0x76F988DAU,
+  0x983E5152U, 0xA831C66DU, 0xB00327C8U, 0xBF597FC7U, 0xC6E00BF3U, 0xD5A79147U, 0x06CA6351U, 0x14292967U,
+  0x27B70A85U, 0x2E1B2138U, 0x4D2C6DFCU, 0x53380D13U, 0x650A7354U, 0x766A0ABBU, 0x81C2C92EU, 0x92722C85U,
+  0xA2BFE8A1U, 0xA81A664BU, 0xC24B8B70U, 0xC76C51A3U, 0xD192E819U, 0xD6990624U, 0xF40E3585U, 0x106AA070U,
+  0x19A4C116U, 0x1E376C08U, 0x2748774CU, 0x34B0BCB5U, 0x391C0CB3U, 0x4ED8AA4AU, 0x5B9CCA4FU, 0x682E6FF3U,
+  0x748F82EEU, 0x78A5636FU, 0x84C87814U, 0x8CC70208U, 0x90BEFFFAU, 0xA4506CEBU, 0xBEF9A3F7U, 0xC67178F2U
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static void OPENBL_HASH_ProcessBlock(HASH_ContextTypeDef *pContext, const uint8_t *pBlock);
+static void OPENBL_HASH_UpdateMemory(HASH_ContextTypeDef *pContext, const OPENBL_MemoryTypeDef *pMemory,
+                                     uint32_t Address, uint32_t Length);
+
+/* Exported variables --------------------------------------------------------*/
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Start a SHA-256 computation.
+  * @param  pContext Pointer to the computation context.
+  * @retval None.
+  */
+void OPENBL_HASH_Init(HASH_ContextTypeDef *pContext)
+{
+  pContext->State[0] = 0x6A09E667U;
+  pContext->State[1] = 0xBB67AE85U;
+  pContext->State[2] = 0x3C6EF372U;
+  pContext->State[3] = 0xA54FF53AU;
+  pContext->State[4] = 0x510E527FU;
+  pContext->State[5] = 0x9B05688CU;
+  pContext->State[6] = 0x1F83D9ABU;
+  pContext->State[7] = 0x5BE0CD19U;
+  pContext->Length   = 0U;
+}
+
+/**
+  * @brief  Add bytes to a SHA-256 computation.
+  * @param  pContext Pointer to the computation context.
+  * @param  pData Pointer to the bytes to be hashed.
+  * @param  Length The number of bytes to be hashed.
+  * @retval None.
+  */
+void OPENBL_HASH_Update(HASH_ContextTypeDef *pContext, const uint8_t *pData, uint32_t Length)
+{
+  uint32_t count = pContext->Length % HASH_BLOCK_SIZE;
+
+  pContext->Length += Length;
+
+  /* Complete the current block first */
+  while ((Length > 0U) && ((count != 0U) || (Length < HASH_BLOCK_SIZE)))
+  {
+    pContext->Block[count] = *pData;
+    count++;
+    pData++;
+    Length--;
+
+    if (count == HASH_BLOCK_SIZE)
+    {
+      OPENBL_HASH_ProcessBlock(pContext, pContext->Block);
+      count = 0U;
+    }
+  }
+
+  /* The full blocks are hashed from the caller buffer */
+  while (Length >= HASH_BLOCK_SIZE)
+  {
+    OPENBL_HASH_ProcessBlock(pContext, pData);
+
+    pData  += HASH_BLOCK_SIZE;
+    Length -= HASH_BLOCK_SIZE;
+  }
+
+  while (Length > 0U)
+  {
+    pContext->Block[count] = *pData;
+    count++;
+    pData++;
+    Length--;
+  }
+}
+
+/**
+  * @brief  End a SHA-256 computation.
+  * @param  pContext Pointer to the computation context.
+  * @param  pDigest Pointer to the 32 bytes of the digest.
+  * @retval None.
+  */
+void OPENBL_HASH_Final(HASH_ContextTypeDef *pContext, uint8_t *pDigest)
+{
+  uint32_t index;
+  uint32_t count = pContext->Length % HASH_BLOCK_SIZE;
+
+  /* Padding: one bit set, zeros, then the length in bits on 64 bits */
+  pContext->Block[count] = 0x80U;
+  count++;
+
+  if (count > (HASH_BLOCK_SIZE - 8U))
+  {
+    while (count < HASH_BLOCK_SIZE)
+    {
+      pContext->Block[count] = 0x00U;
+      count++;
+    }
+
+    OPENBL_HASH_ProcessBlock(pContext, pContext->Block);
+    count = 0U;
+  }
+
+  while (count < (HASH_BLOCK_SIZE - 8U))
+  {
+    pContext->Block[count] = 0x00U;
+    count++;
+  }
+
+  pContext->Block[56] = 0x00U;
+  pContext->Block[57] = 0x00U;
+  pContext->Block[58] = 0x00U;
+  pContext->Block[59] = (uint8_t)(pContext->Length >> 29U);
+  pContext->Block[60] = (uint8_t)(pContext->Length >> 21U);
+  pContext->Block[61] = (uint8_t)(pContext->Length >> 13U);
+  pContext->Block[62] = (uint8_t)(pContext->Length >> 5U);
+  pContext->Block[63] = (uint8_t)(pContext->Length << 3U);
+
+  OPENBL_HASH_ProcessBlock(pContext, pContext->Block);
+
+  for (index = 0U; index < 8U; index++)
+  {
+    pDigest[(index * 4U)]      = (uint8_t)(pContext->State[index] >> 24U);
+    pDigest[(index * 4U) + 1U] = (uint8_t)(pContext->State[index] >> 16U);
+    pDigest[(index * 4U) + 2U] = (uint8_t)(pContext->State[index] >> 8U);
+    pDigest[(index * 4U) + 3U] = (uint8_t)(pContext->State[index]);
+  }
+}
+
+/**
+  * @brief  This function is used to process the digest special command.
+  *         Buffer1 contains the start address and the length of a range of any memory, 4 bytes each MSB
+  *         first. The response data is the SHA-256 digest of the range. The status is NACK if the range
+  *         is not inside one memory or if the read protection is active.
+  * @param  SpecialCmd Pointer to the OPENBL_SpecialCmdTypeDef structure.
+  * @param  SendByte The function used to send one byte through the detected interface.
+  * @retval None.
+  */
+void OPENBL_HASH_Command(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte)
+{
+  uint32_t index;
+  uint32_t address;
+  uint32_t length;
+  uint8_t digest[HASH_DIGEST_SIZE];
+  HASH_ContextTypeDef context;
+  const OPENBL_MemoryTypeDef *p_memory = NULL;
+  ErrorStatus status = ERROR;
+
+  if ((SpecialCmd->SizeBuffer1 == 8U) && (Common_GetProtectionStatus() == RESET))
+  {
+    address  = Common_GetWord(&SpecialCmd->Buffer1[0]);
+    length   = Common_GetWord(&SpecialCmd->Buffer1[4]);
+    p_memory = Common_GetMemory(address, length);
+
+    if (p_memory != NULL)
+    {
+      OPENBL_HASH_Init(&context);
+      OPENBL_HASH_UpdateMemory(&context, p_memory, address, length);
+      OPENBL_HASH_Final(&context, digest);
+
+      status = SUCCESS;
+    }
+  }
+
+  if (SpecialCmd->CmdType == OPENBL_SPECIAL_CMD)
+  {
+    if (status == SUCCESS)
+    {
+      Common_SendHalfWord(SendByte, HASH_DIGEST_SIZE);
+
+      for (index = 0U; index < HASH_DIGEST_SIZE; index++)
+      {
+        SendByte(digest[index]);
+      }
+    }
+    else
+    {
+      /* Send NULL data size */
+      Common_SendHalfWord(SendByte, 0U);
+    }
+  }
+
+  Common_SendSpecialCmdStatus(SendByte, status);
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Add a memory range to a SHA-256 computation.
+  * @note   The range is hashed in place when its memory is mapped, otherwise it is copied through the
+  *         Read callback of its memory, so that the bytes hidden by the callback are not hashed.
+  * @param  pContext Pointer to the computation context.
+  * @param  pMemory Pointer to the memory descriptor of the range.
+  * @param  Address The start address of the range.
+  * @param  Length The length of the range in bytes.
+  * @retval None.
+  */
+static void OPENBL_HASH_UpdateMemory(HASH_ContextTypeDef *pContext, const OPENBL_MemoryTypeDef *pMemory,
+                                     uint32_t Address, uint32_t Length)
+{
+  uint32_t chunk;
+  const uint8_t *p_data;
+  uint8_t block[HASH_BLOCK_SIZE];
+
+  while (Length > 0U)
+  {
+    OPENBL_IWDG_Refresh();
+
+    chunk  = (Length > HASH_CHUNK_SIZE) ? HASH_CHUNK_SIZE : Length;
+    p_data = Common_ReadBlock(pMemory, Address, block, HASH_BLOCK_SIZE, &chunk);
+
+    OPENBL_HASH_Update(pContext, p_data, chunk);
+
+    Address += chunk;
+    Length  -= chunk;
+  }
+}
+
+/**
+  * @brief  Hash one 64 bytes block.
+  * @param  pContext Pointer to the computation context.
+  * @param  pBlock Pointer to the block.
+  * @retval None.
+  */
+static void OPENBL_HASH_ProcessBlock(HASH_ContextTypeDef *pContext, const uint8_t *pBlock)
+{
+  uint32_t index;
+  uint32_t temp1;
+  uint32_t temp2;
+  uint32_t w[64];
+  uint32_t s[8];
+
+  if (((uint32_t)pBlock & 0x3U) == 0U)
+  {
+    /* Aligned block: one word load and one byte reversal per message word */
+    for (index = 0U; index < 16U; index++)
+    {
+      w[index] = __REV(((const uint32_t *)pBlock)[index]);
+    }
+  }
+  else
+  {
+    for (index = 0U; index < 16U; index++)
+    {
+      w[index] = ((uint32_t)pBlock[index * 4U] << 24U) | ((uint32_t)pBlock[(index * 4U) + 1U] << 16U)
+                 | ((uint32_t)pBlock[(index * 4U) + 2U] << 8U) | (uint32_t)pBlock[(index * 4U) + 3U];
+    }
+  }
+
+  for (index = 16U; index < 64U; index++)
+  {
+    temp1 = HASH_ROTR(w[index - 15U], 7U) ^ HASH_ROTR(w[index - 15U], 18U) ^ (w[index - 15U] >> 3U);
+    temp2 = HASH_ROTR(w[index - 2U], 17U) ^ HASH_ROTR(w[index - 2U], 19U) ^ (w[index - 2U] >> 10U);
+
+    w[index] = w[index - 16U] + temp1 + w[index - 7U] + temp2;
+  }
+
+  for (index = 0U; index < 8U; index++)
+  {
+    s[index] = pContext->State[index];
+  }
+
+  for (index = 0U; index < 64U; index++)
+  {
+    temp1 = s[7] + (HASH_ROTR(s[4], 6U) ^ HASH_ROTR(s[4], 11U) ^ HASH_ROTR(s[4], 25U))
+            + ((s[4] & s[5]) ^ (~s[4] & s[6])) + HashRoundConstants[index] + w[index];
+    temp2 = (HASH_ROTR(s[0], 2U) ^ HASH_ROTR(s[0], 13U) ^ HASH_ROTR(s[0], 22U))
+            + ((s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]));
+
+    s[7] = s[6];
+    s[6] = s[5];
+    s[5] = s[4];
+    s[4] = s[3] + temp1;
+    s[3] = s[2];
+    s[2] = s[1];
+    s[1] = s[0];
+    s[0] = temp1 + temp2;
+  }
+
+  for (index = 0U; index < 8U; index++)
+  {
+    pContext->State[index] += s[index];
+  }
+}
@@ -0,0 +1,54 @@
+/**
+  ******************************************************************************
+  * @file    hash_interface.h
+  * @author  MCD Application Team
+  * @brief   Header for hash_interface.c module
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef HASH_INTERFACE_H
+#define HASH_INTERFACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "openbl_core.h"
+#include "common_interface.h"
+
+/* Exported types ------------------------------------------------------------*/
+/* SHA-256 computation context */
+typedef struct
+{
+  uint32_t State[8];     /* Intermediate hash value */
+  uint32_t Length;       /* Number of bytes hashed */
+  uint8_t  Block[64];    /* Bytes of the current block */
+} HASH_ContextTypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+#define HASH_DIGEST_SIZE                  32U  /* Size of a SHA-256 digest */
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+void OPENBL_HASH_Init(HASH_ContextTypeDef *pContext);
+void OPENBL_HASH_Update(HASH_ContextTypeDef *pContext, const uint8_t *pData, uint32_t Length);
+void OPENBL_HASH_Final(HASH_ContextTypeDef *pContext, uint8_t *pDigest);
+void OPENBL_HASH_Command(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HASH_INTERFACE_H */
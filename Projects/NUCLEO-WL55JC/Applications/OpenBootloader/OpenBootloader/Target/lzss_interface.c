@@ -0,0 +1,254 @@
+/**
+  ******************************************************************************
+  * @file    lzss_interface.c
+  * @author  MCD Application Team
+  * @brief   Contains LZSS decompression functions used by the compressed write
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "platform.h"
+#include "openbl_core.h"
+#include "app_openbootloader.h"
+#include "common_interface.h"
+#include "lzss_interface.h"
+#include "flash_interface.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* State of the compressed stream, kept between two compressed write commands */
+typedef struct
+{
+  uint32_t Address;       /* FLASH address of the first decoded byte */
+  uint32_t Length;        /* Number of decoded bytes */
+  uint32_t Written;       /* Number of decoded bytes given to the FLASH interface */
+  uint32_t Flags;         /* Type bits of the next tokens, above a sentinel bit */
+  uint32_t MatchByte;     /* First byte of a match token split between two commands */
+  uint8_t  MatchPending;  /* The first byte of a match token is received */
+  uint8_t  Started;       /* A stream is started and no error occurred */
+} LZSS_StreamTypeDef;
+
+/* Private define ------------------------------------------------------------*/
+#define LZSS_CMD_START                    0x00U  /* Start a stream at the given address */
+#define LZSS_CMD_CONTINUE                 0x01U  /* Decode the next bytes of the stream */
+#define LZSS_CMD_END                      0x02U  /* End the stream and program its last bytes */
+
+#define LZSS_MIN_MATCH                    3U     /* Length of a match token with a null length field */
+#define LZSS_WRITE_SIZE                   256U   /* Decoded bytes given at once to the FLASH interface */
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static LZSS_StreamTypeDef LzssStream = {0U};
+
+/* The window is in the RAM not used by the Open Bootloader */
+static uint8_t *const LzssWindow = (uint8_t *)LZSS_WINDOW_ADDRESS;
+
+/* Private function prototypes -----------------------------------------------*/
+static ErrorStatus OPENBL_LZSS_Decode(uint8_t *pData, uint32_t Length);
+static ErrorStatus OPENBL_LZSS_PutByte(uint8_t Byte);
+static void OPENBL_LZSS_WriteWindow(void);
+
+/* Exported variables --------------------------------------------------------*/
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  This function is used to process the compressed write extended special command.
+  *         Buffer1 is 0x00 followed by the FLASH address (4 bytes MSB first) to start a stream, 0x01 to
+  *         continue it or 0x02 to end it. Buffer2 contains the next LZSS compressed bytes of the stream.
+  *         The decoded bytes are written in FLASH as they are produced, the stream can be split at any
+  *         byte between two commands. The status is NACK if the stream is not valid, and at the end of
+  *         the stream if a FLASH programming error occurred.
+  * @param  SpecialCmd Pointer to the OPENBL_SpecialCmdTypeDef structure.
+  * @param  SendByte The function used to send one byte through the detected interface.
+  * @retval None.
+  */
+void OPENBL_LZSS_WriteCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte)
+{
+  uint32_t address;
+  ErrorStatus status = ERROR;
+
+  if (Common_GetProtectionStatus() != RESET)
+  {
+    LzssStream.Started = 0U;
+  }
+  else if ((SpecialCmd->SizeBuffer1 == 5U) && (SpecialCmd->Buffer1[0] == LZSS_CMD_START))
+  {
+    address = Common_GetWord(&SpecialCmd->Buffer1[1]);
+
+    if ((address >= FLASH_START_ADDRESS) && (address < FLASH_END_ADDRESS))
+    {
+      LzssStream.Address      = address;
+      LzssStream.Length       = 0U;
+      LzssStream.Written      = 0U;
+      LzssStream.Flags        = 1U;
+      LzssStream.MatchPending = 0U;
+      LzssStream.Started      = 1U;
+
+      status = SUCCESS;
+    }
+  }
+  else if ((SpecialCmd->SizeBuffer1 == 1U) && (SpecialCmd->Buffer1[0] == LZSS_CMD_CONTINUE))
+  {
+    status = (LzssStream.Started != 0U) ? SUCCESS : ERROR;
+  }
+  else if ((SpecialCmd->SizeBuffer1 == 1U) && (SpecialCmd->Buffer1[0] == LZSS_CMD_END))
+  {
+    /* A stream can not end in the middle of a match token */
+    if ((LzssStream.Started != 0U) && (LzssStream.MatchPending == 0U))
+    {
+      status = SUCCESS;
+    }
+
+    LzssStream.Started = 0U;
+  }
+  else
+  {
+    /* Unknown operation */
+  }
+
+  if ((status == SUCCESS) && (SpecialCmd->SizeBuffer2 != 0U))
+  {
+    status = OPENBL_LZSS_Decode(SpecialCmd->Buffer2, SpecialCmd->SizeBuffer2);
+  }
+
+  if (status == SUCCESS)
+  {
+    OPENBL_LZSS_WriteWindow();
+
+    if (SpecialCmd->Buffer1[0] == LZSS_CMD_END)
+    {
+      OPENBL_FLASH_FlushWriteCache();
+
+      status = OPENBL_FLASH_GetWriteStatus();
+    }
+  }
+  else
+  {
+    /* The next bytes of a broken stream can not be decoded */
+    LzssStream.Started = 0U;
+  }
+
+  Common_SendSpecialCmdStatus(SendByte, status);
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Decode the next compressed bytes of the stream.
+  * @note   Each flag byte gives the type of the next 8 tokens, least significant bit first: 1 for a
+  *         literal byte, 0 for a 2 bytes match token. The match token holds the offset minus 1 on
+  *         12 bits, then the length minus 3 on 4 bits, most significant bits first.
+  * @param  pData Pointer to the compressed bytes.
+  * @param  Length The number of compressed bytes.
+  * @retval An ErrorStatus enumeration value:
+  *          - SUCCESS: The bytes are decoded
+  *          - ERROR:   A match token refers to a byte before the stream or the FLASH end is reached
+  */
+static ErrorStatus OPENBL_LZSS_Decode(uint8_t *pData, uint32_t Length)
+{
+  uint32_t index = 0U;
+  uint32_t offset;
+  uint32_t count;
+  ErrorStatus status = SUCCESS;
+
+  while ((index < Length) && (status == SUCCESS))
+  {
+    if (LzssStream.Flags == 1U)
+    {
+      /* Only the sentinel bit is left, the next byte is a flag byte */
+      LzssStream.Flags = (uint32_t)pData[index] | 0x100U;
+    }
+    else if ((LzssStream.Flags & 0x1U) != 0U)
+    {
+      status = OPENBL_LZSS_PutByte(pData[index]);
+
+      LzssStream.Flags >>= 1U;
+    }
+    else if (LzssStream.MatchPending == 0U)
+    {
+      LzssStream.MatchByte    = pData[index];
+      LzssStream.MatchPending = 1U;
+    }
+    else
+    {
+      offset = ((LzssStream.MatchByte << 4U) | ((uint32_t)pData[index] >> 4U)) + 1U;
+      count  = ((uint32_t)pData[index] & 0x0FU) + LZSS_MIN_MATCH;
+
+      LzssStream.MatchPending = 0U;
+      LzssStream.Flags >>= 1U;
+
+      if (offset > LzssStream.Length)
+      {
+        status = ERROR;
+      }
+
+      /* The source may overlap the copied bytes, so the match is copied byte per byte */
+      while ((count > 0U) && (status == SUCCESS))
+      {
+        status = OPENBL_LZSS_PutByte(LzssWindow[(LzssStream.Length - offset) % LZSS_WINDOW_SIZE]);
+        count--;
+      }
+    }
+
+    index++;
+  }
+
+  return status;
+}
+
+/**
+  * @brief  Add a decoded byte to the window, and write the window to the FLASH every 256 bytes.
+  * @param  Byte The decoded byte.
+  * @retval An ErrorStatus enumeration value:
+  *          - SUCCESS: The byte is added
+  *          - ERROR:   The byte is beyond the FLASH end
+  */
+static ErrorStatus OPENBL_LZSS_PutByte(uint8_t Byte)
+{
+  ErrorStatus status = SUCCESS;
+
+  if (LzssStream.Length >= (FLASH_END_ADDRESS - LzssStream.Address))
+  {
+    status = ERROR;
+  }
+  else
+  {
+    LzssWindow[LzssStream.Length % LZSS_WINDOW_SIZE] = Byte;
+    LzssStream.Length++;
+
+    /* The window size is a multiple of the write size, so a write never wraps around the window */
+    if ((LzssStream.Length % LZSS_WRITE_SIZE) == 0U)
+    {
+      OPENBL_LZSS_WriteWindow();
+    }
+  }
+
+  return status;
+}
+
+/**
+  * @brief  Give the decoded bytes not written yet to the FLASH interface.
+  * @note   The FLASH interface caches a partial double word until the next bytes are written.
+  * @retval None.
+  */
+static void OPENBL_LZSS_WriteWindow(void)
+{
+  uint32_t length = LzssStream.Length - LzssStream.Written;
+
+  if (length != 0U)
+  {
+    OPENBL_FLASH_Write(LzssStream.Address + LzssStream.Written,
+                       &LzssWindow[LzssStream.Written % LZSS_WINDOW_SIZE], length);
+
+    LzssStream.Written += length;
+  }
+}
@@ -54,12 +54,31 @@ extern "C" {
 #define OTP_BL_SIZE                       1024U  /* Size of OTP 1024 Byte */
 #define OTP_START_ADDRESS                 0x1FFF7000U  /* OTP registers address */
 #define OTP_END_ADDRESS                   (OTP_START_ADDRESS + OTP_BL_SIZE)  /* OTP end address */
+#define CRYP_KEY_ADDRESS                  (OTP_END_ADDRESS - 16U)  /* AES-128 key of the encrypted write, not readable */
+#define SIGN_PUBLIC_KEY_ADDRESS           (CRYP_KEY_ADDRESS - 64U)  /* ECDSA P-256 public key of the image signature */
 
 #define EB_SIZE                           1024U  /* Size of Engi bytes 1024 Byte */
 #define EB_START_ADDRESS                  0x1FFF7400U  /* Engi bytes start address */
 #define EB_END_ADDRESS                    (EB_START_ADDRESS + EB_SIZE)  /* Engi bytes end address */
 
-#define OPENBL_RAM_SIZE                   (6U * 1024U)  /* RAM used by the Open Bootloader 6 kBytes */
+#define OPENBL_RAM_SIZE                   (8U * 1024U)  /* RAM used by the Open Bootloader 8 kBytes, RAM region of the linker files */
+#define LZSS_WINDOW_ADDRESS               (RAM_START_ADDRESS + OPENBL_RAM_SIZE)  /* Window of the compressed write */
+#define LZSS_WINDOW_SIZE                  (4U * 1024U)  /* Reached by the 12-bit offset of the match tokens */
+#define RAM_USER_START_ADDRESS            (LZSS_WINDOW_ADDRESS + LZSS_WINDOW_SIZE)  /* First RAM address accessible by the host */
+#define RAM_LOADER_START_ADDRESS          RAM_USER_START_ADDRESS  /* RAM loaders code area start */
+#define RAM_LOADER_END_ADDRESS            0x20008000U  /* RAM loaders code area end, SRAM2 is used by the Open Bootloader */
+
+/* A/B application slots, located after the FLASH used by the Open Bootloader */
+#define OPENBL_FLASH_SIZE                 (48U * 1024U)  /* FLASH used by the Open Bootloader 48 kBytes, ROM region of the linker files */
+#define FLASH_SLOT_METADATA_ADDRESS       (FLASH_START_ADDRESS + OPENBL_FLASH_SIZE)  /* Two pages of slot records */
+#define FLASH_SLOT_METADATA_SIZE          (4U * 1024U)  /* Size of the slot records area 4 kByte */
+#define FLASH_JOURNAL_ADDRESS             (FLASH_SLOT_METADATA_ADDRESS + FLASH_SLOT_METADATA_SIZE)  /* Two pages of download journal */
+#define FLASH_JOURNAL_SIZE                (4U * 1024U)  /* Size of the download journal area 4 kByte */
+#define FLASH_WEAR_LOG_ADDRESS            (FLASH_JOURNAL_ADDRESS + FLASH_JOURNAL_SIZE)  /* Two pages of erase counters log */
+#define FLASH_WEAR_LOG_SIZE               (4U * 1024U)  /* Size of the erase counters log area 4 kByte */
+#define FLASH_SLOT_A_ADDRESS              (FLASH_WEAR_LOG_ADDRESS + FLASH_WEAR_LOG_SIZE)  /* Start of slot A */
+#define FLASH_SLOT_SIZE                   (98U * 1024U)  /* Size of each slot 98 kByte */
+#define FLASH_SLOT_B_ADDRESS              (FLASH_SLOT_A_ADDRESS + FLASH_SLOT_SIZE)  /* Start of slot B */
 
 #define OPENBL_DEFAULT_MEM                FLASH_START_ADDRESS  /* Address used for the Erase, Writep and readp command */
 
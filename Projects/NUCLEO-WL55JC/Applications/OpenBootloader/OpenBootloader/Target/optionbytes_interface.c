@@ -22,6 +22,7 @@
 #include "app_openbootloader.h"
 #include "common_interface.h"
 #include "optionbytes_interface.h"
+#include "flash_interface.h"
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
@@ -29,7 +30,7 @@
 /* Private variables ---------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
 /* Exported variables --------------------------------------------------------*/
-OPENBL_MemoryTypeDef OB1_Descriptor =
+const OPENBL_MemoryTypeDef OB1_Descriptor =
 {
   OB1_START_ADDRESS,
   OB1_END_ADDRESS,
@@ -81,6 +82,9 @@ void OPENBL_OB_Write(uint32_t Address, uint8_t *Data, uint32_t DataLength)
 {
   uint32_t timeout = 0U;
 
+  /* Option bytes are programmed through the FLASH controller, let the background erase finish first */
+  OPENBL_FLASH_WaitForPendingErase();
+
   /* Unlock the FLASH & Option Bytes Registers access */
   HAL_FLASH_Unlock();
   HAL_FLASH_OB_Unlock();
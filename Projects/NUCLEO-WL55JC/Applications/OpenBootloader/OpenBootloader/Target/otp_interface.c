@@ -22,18 +22,30 @@
 #include "app_openbootloader.h"
 #include "common_interface.h"
 #include "otp_interface.h"
+#include "flash_interface.h"
+#include "program_interface.h"
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
 #define OTP_PROG_STEP_SIZE                ((uint8_t)0x8U)
+#define OTP_STATUS_SIZE                   8U  /* Size of the response data of the OTP status command */
+#define OTP_CHUNK_SIZE                    (32U * OTP_PROG_STEP_SIZE)  /* Bytes read back together, one bit of the queued mask per double word */
 
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
+/* Double words given to the OTP interface since the previous OTP status command */
+static uint32_t OtpProgrammedNumber = 0U;  /* Blank double words programmed */
+static uint32_t OtpSkippedNumber    = 0U;  /* Double words already holding the data */
+static uint32_t OtpConflictNumber   = 0U;  /* Double words already holding other data, not programmed */
+static uint32_t OtpFailedNumber     = 0U;  /* Double words not reading back with the data after programming */
+
 /* Private function prototypes -----------------------------------------------*/
-static void OPENBL_OTP_Program(uint32_t Address, uint64_t Data);
+static FlagStatus OPENBL_OTP_Program(uint32_t Address, uint64_t Data);
+static uint64_t OPENBL_OTP_GetDoubleWord(uint8_t *pData, uint32_t DataLength);
+static uint64_t OPENBL_OTP_ReadDoubleWord(uint32_t Address);
 
 /* Exported variables --------------------------------------------------------*/
-OPENBL_MemoryTypeDef OTP_Descriptor =
+const OPENBL_MemoryTypeDef OTP_Descriptor =
 {
   OTP_START_ADDRESS,
   OTP_END_ADDRESS,
@@ -52,12 +64,53 @@ OPENBL_MemoryTypeDef OTP_Descriptor =
 
 /**
   * @brief  This function is used to read data from a given address.
+  * @note   The AES key of the encrypted write is read as 0x00.
   * @param  Address The address to be read.
   * @retval Returns the read value.
   */
 uint8_t OPENBL_OTP_Read(uint32_t Address)
 {
-  return (*(uint8_t *)(Address));
+  uint8_t data = 0x00U;
+
+  if ((Address < CRYP_KEY_ADDRESS) || (Address >= OTP_END_ADDRESS))
+  {
+    data = *(uint8_t *)(Address);
+  }
+
+  return data;
+}
+
+/**
+  * @brief  This function is used to read a block of data from a given address.
+  * @note   The block is read in place, unless it overlaps the AES key: it is then copied in the buffer
+  *         byte per byte as by OPENBL_OTP_Read().
+  * @param  Address The address of the block, the block must be inside the OTP area.
+  * @param  pBuffer Pointer to the buffer used when the block can not be read in place.
+  * @param  BufferSize The size of the buffer in bytes.
+  * @param  pLength Pointer to the length of the block, updated with the number of bytes returned.
+  * @retval Returns a pointer to the bytes of the block.
+  */
+const uint8_t *OPENBL_OTP_ReadBlock(uint32_t Address, uint8_t *pBuffer, uint32_t BufferSize, uint32_t *pLength)
+{
+  uint32_t index;
+  uint32_t length = *pLength;
+  const uint8_t *p_data = (const uint8_t *)Address;
+
+  if ((Address + length) > CRYP_KEY_ADDRESS)
+  {
+    length = (length > BufferSize) ? BufferSize : length;
+
+    for (index = 0U; index < length; index++)
+    {
+      pBuffer[index] = OPENBL_OTP_Read(Address + index);
+    }
+
+    p_data = pBuffer;
+  }
+
+  *pLength = length;
+
+  return p_data;
 }
 
 /**
@@ -70,45 +123,66 @@ uint8_t OPENBL_OTP_Read(uint32_t Address)
 void OPENBL_OTP_Write(uint32_t Address, uint8_t *pData, uint32_t DataLength)
 {
   uint32_t index;
-  uint8_t remaining_data[OTP_PROG_STEP_SIZE] = {0x0};
-  uint8_t remaining;
+  uint32_t offset;
+  uint32_t chunk;
+  uint32_t queued;
 
   if ((pData != NULL) && (DataLength != 0U))
   {
-    /* Unlock the flash memory for write operation */
-    HAL_FLASH_Unlock();
+    /* OTP is programmed through the FLASH controller, let the background erase finish first. The
+       FLASH double words still queued are programmed before and their errors kept by the FLASH interface */
+    OPENBL_FLASH_WaitForPendingErase();
 
-    /* Program double-word by double-word (8 bytes) */
-    while ((DataLength >> 3U) > 0U)
-    {
-      OPENBL_OTP_Program(Address, (uint64_t)(*((uint64_t *)((uint32_t)pData))));
+    /* Hold the erase queue so that the FLASH interrupt does not lock the FLASH while programming */
+    OPENBL_FLASH_SuspendErase();
 
-      Address    += OTP_PROG_STEP_SIZE;
-      pData      += OTP_PROG_STEP_SIZE;
-      DataLength -= OTP_PROG_STEP_SIZE;
-    }
+    /* Unlock the flash memory for write operation */
+    HAL_FLASH_Unlock();
 
-    /* If remaining count, go back to fill the rest with 0xFF */
-    if (DataLength > 0U)
+    /* Program double-word by double-word (8 bytes), the last one is completed with 0xFF */
+    while (DataLength > 0U)
     {
-      remaining = OTP_PROG_STEP_SIZE - DataLength;
+      chunk  = (DataLength > OTP_CHUNK_SIZE) ? OTP_CHUNK_SIZE : DataLength;
+      queued = 0U;
 
-      /* copy the remaining bytes */
-      for (index = 0U; index < DataLength; index++)
+      for (index = 0U; (index * OTP_PROG_STEP_SIZE) < chunk; index++)
       {
-        remaining_data[index] = *(pData + index);
+        offset = index * OTP_PROG_STEP_SIZE;
+
+        if (OPENBL_OTP_Program(Address + offset, OPENBL_OTP_GetDoubleWord(pData + offset, chunk - offset)) == SET)
+        {
+          queued |= (1UL << index);
+        }
       }
 
-      /* Fill the upper bytes with 0xFF */
-      for (index = 0U; index < remaining; index++)
+      /* Wait until the queued double words are programmed, a failure is reported as a write error */
+      OPENBL_FLASH_WaitForProgram();
+
+      /* A queued double word is only counted as programmed once it reads back with the data */
+      for (index = 0U; (index * OTP_PROG_STEP_SIZE) < chunk; index++)
       {
-        remaining_data[index + DataLength] = 0xFFU;
+        if ((queued & (1UL << index)) != 0U)
+        {
+          offset = index * OTP_PROG_STEP_SIZE;
+
+          if (OPENBL_OTP_ReadDoubleWord(Address + offset) == OPENBL_OTP_GetDoubleWord(pData + offset, chunk - offset))
+          {
+            OtpProgrammedNumber++;
+          }
+          else
+          {
+            OtpFailedNumber++;
+          }
+        }
       }
 
-      /* FLASH word program */
-      OPENBL_OTP_Program(Address, (uint64_t)(*((uint64_t *)((uint32_t)remaining_data))));
+      Address    += chunk;
+      pData      += chunk;
+      DataLength -= chunk;
     }
 
+    OPENBL_FLASH_ResumeErase();
+
     /* Lock the Flash to disable the flash control register access */
     HAL_FLASH_Lock();
   }
@@ -117,18 +191,124 @@ void OPENBL_OTP_Write(uint32_t Address, uint8_t *pData, uint32_t DataLength)
   HAL_FLASH_Lock();
 }
 
+/**
+  * @brief  This function is used to process the OTP status special command.
+  *         Buffer1 is empty. The response data is the number of double words programmed, skipped because
+  *         they already held the data and not programmed because they held other data, since the previous
+  *         OTP status command, followed by the number of double words that did not read back with
+  *         the data after programming, 2 bytes each MSB first. The status is NACK if a double word was
+  *         not programmed because of a conflict or if its programming failed.
+  * @param  SpecialCmd Pointer to the OPENBL_SpecialCmdTypeDef structure.
+  * @param  SendByte The function used to send one byte through the detected interface.
+  * @retval None.
+  */
+void OPENBL_OTP_StatusCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte)
+{
+  ErrorStatus status = ERROR;
+
+  if ((SpecialCmd->SizeBuffer1 == 0U) && (OtpConflictNumber == 0U) && (OtpFailedNumber == 0U))
+  {
+    status = SUCCESS;
+  }
+
+  if (SpecialCmd->CmdType == OPENBL_SPECIAL_CMD)
+  {
+    if (SpecialCmd->SizeBuffer1 == 0U)
+    {
+      Common_SendHalfWord(SendByte, OTP_STATUS_SIZE);
+      Common_SendHalfWord(SendByte, (uint16_t)OtpProgrammedNumber);
+      Common_SendHalfWord(SendByte, (uint16_t)OtpSkippedNumber);
+      Common_SendHalfWord(SendByte, (uint16_t)OtpConflictNumber);
+      Common_SendHalfWord(SendByte, (uint16_t)OtpFailedNumber);
+    }
+    else
+    {
+      /* Send NULL data size */
+      Common_SendHalfWord(SendByte, 0U);
+    }
+  }
+
+  if (SpecialCmd->SizeBuffer1 == 0U)
+  {
+    OtpProgrammedNumber = 0U;
+    OtpSkippedNumber    = 0U;
+    OtpConflictNumber   = 0U;
+    OtpFailedNumber     = 0U;
+  }
+
+  Common_SendSpecialCmdStatus(SendByte, status);
+}
+
 /* Private functions ---------------------------------------------------------*/
 
 /**
-  * @brief  Program double word at a specified FLASH address.
+  * @brief  Queue double word at a specified FLASH address.
+  * @note   The double word is queued to the FLASH programming engine only if it is blank. It is skipped
+  *         if it already holds the data, so that a provisioning sequence can be run again, and it is
+  *         counted as a conflict without any programming attempt if it holds other data.
   * @param  Address specifies the address to be programmed.
   * @param  Data specifies the data to be programmed.
-  * @retval None.
+  * @retval Returns SET if the double word is queued, it is counted once read back, else RESET.
   */
-static void OPENBL_OTP_Program(uint32_t Address, uint64_t Data)
+static FlagStatus OPENBL_OTP_Program(uint32_t Address, uint64_t Data)
 {
-  /* Clear all FLASH errors flags before starting write operation */
-  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+  FlagStatus status = RESET;
+  uint64_t current;
+
+  if ((Address & (OTP_PROG_STEP_SIZE - 1U)) != 0U)
+  {
+    /* The OTP is only programmed by aligned double words */
+    OtpConflictNumber++;
+  }
+  else
+  {
+    current = OPENBL_OTP_ReadDoubleWord(Address);
 
-  HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, Address, Data);
+    if (current == Data)
+    {
+      OtpSkippedNumber++;
+    }
+    else if (current == 0xFFFFFFFFFFFFFFFFULL)
+    {
+      OPENBL_PROG_Submit(Address, Data);
+
+      status = SET;
+    }
+    else
+    {
+      OtpConflictNumber++;
+    }
+  }
+
+  return status;
+}
+
+/**
+  * @brief  Build the double word to be programmed from the data.
+  * @param  pData Pointer to the data of the double word.
+  * @param  DataLength The number of data bytes left, the bytes after the data are set to 0xFF.
+  * @retval Returns the double word.
+  */
+static uint64_t OPENBL_OTP_GetDoubleWord(uint8_t *pData, uint32_t DataLength)
+{
+  uint64_t data = 0xFFFFFFFFFFFFFFFFULL;
+  uint32_t index;
+
+  for (index = 0U; (index < OTP_PROG_STEP_SIZE) && (index < DataLength); index++)
+  {
+    data &= ~((uint64_t)0xFFU << (index * 8U));
+    data |= (uint64_t)pData[index] << (index * 8U);
+  }
+
+  return data;
+}
+
+/**
+  * @brief  Read the double word at a specified OTP address.
+  * @param  Address specifies the address to be read, aligned on a double word.
+  * @retval Returns the double word.
+  */
+static uint64_t OPENBL_OTP_ReadDoubleWord(uint32_t Address)
+{
+  return ((uint64_t)(*(__IO uint32_t *)(Address + 4U)) << 32U) | (uint64_t)(*(__IO uint32_t *)Address);
 }
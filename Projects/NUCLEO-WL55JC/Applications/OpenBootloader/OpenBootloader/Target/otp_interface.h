@@ -25,11 +25,16 @@ extern "C" {
 #endif
 
 /* Includes ------------------------------------------------------------------*/
+#include "openbl_core.h"
+#include "common_interface.h"
+
 /* Exported types ------------------------------------------------------------*/
 /* Exported constants --------------------------------------------------------*/
 /* Exported macro ------------------------------------------------------------*/
 /* Exported functions ------------------------------------------------------- */
 uint8_t OPENBL_OTP_Read(uint32_t Address);
+const uint8_t *OPENBL_OTP_ReadBlock(uint32_t Address, uint8_t *pBuffer, uint32_t BufferSize, uint32_t *pLength);
+void OPENBL_OTP_StatusCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte);
 void OPENBL_OTP_Write(uint32_t Address, uint8_t *Data, uint32_t DataLength);
 
 #ifdef __cplusplus
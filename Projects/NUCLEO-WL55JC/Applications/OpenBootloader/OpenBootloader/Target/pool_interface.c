@@ -0,0 +1,129 @@
+/**
+  ******************************************************************************
+  * @file    pool_interface.c
+  * @author  MCD Application Team
+  * @brief   Contains the pool of transfer buffers located in SRAM2
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "platform.h"
+#include "openbl_core.h"
+#include "common_interface.h"
+#include "pool_interface.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+#define POOL_STATS_SIZE                   7U  /* Size of the response data of the statistics command */
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* The blocks are not initialized by the startup code, the section is placed in SRAM2 by the linker */
+__attribute__((section(".RAM2_region"))) static uint32_t PoolBlocks[POOL_BLOCK_NUMBER][POOL_BLOCK_SIZE / 4U];
+
+static uint32_t PoolUsedMask     = 0U;  /* One bit per block borrowed */
+static uint32_t PoolUsedNumber   = 0U;  /* Number of blocks borrowed */
+static uint32_t PoolHighWater    = 0U;  /* Highest number of blocks borrowed at the same time */
+static uint32_t PoolFailedNumber = 0U;  /* Number of borrows refused because all the blocks were borrowed */
+
+/* Private function prototypes -----------------------------------------------*/
+/* Exported variables --------------------------------------------------------*/
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Borrow a block of the pool.
+  * @note   The pool is only used in thread mode, a block is kept until it is released.
+  * @retval Returns a pointer to a word aligned block of POOL_BLOCK_SIZE bytes, or NULL if all the
+  *         blocks are borrowed.
+  */
+uint8_t *OPENBL_POOL_Get(void)
+{
+  uint32_t index;
+  uint8_t *p_block = NULL;
+
+  for (index = 0U; (index < POOL_BLOCK_NUMBER) && (p_block == NULL); index++)
+  {
+    if ((PoolUsedMask & (1UL << index)) == 0U)
+    {
+      PoolUsedMask |= (1UL << index);
+      PoolUsedNumber++;
+
+      if (PoolUsedNumber > PoolHighWater)
+      {
+        PoolHighWater = PoolUsedNumber;
+      }
+
+      p_block = (uint8_t *)PoolBlocks[index];
+    }
+  }
+
+  if ((p_block == NULL) && (PoolFailedNumber < 0xFFFFU))
+  {
+    PoolFailedNumber++;
+  }
+
+  return p_block;
+}
+
+/**
+  * @brief  Give a block back to the pool.
+  * @param  pBlock Pointer to the block, NULL is ignored.
+  * @retval None.
+  */
+void OPENBL_POOL_Release(uint8_t *pBlock)
+{
+  uint32_t index;
+
+  for (index = 0U; index < POOL_BLOCK_NUMBER; index++)
+  {
+    if ((pBlock == (uint8_t *)PoolBlocks[index]) && ((PoolUsedMask & (1UL << index)) != 0U))
+    {
+      PoolUsedMask &= ~(1UL << index);
+      PoolUsedNumber--;
+    }
+  }
+}
+
+/**
+  * @brief  This function is used to process the buffer pool statistics special command.
+  *         Buffer1 is empty. The response data is the block size (2 bytes), the number of blocks, the
+  *         number of blocks borrowed, the highest number of blocks borrowed at the same time (1 byte
+  *         each) and the number of refused borrows (2 bytes), MSB first.
+  * @param  SpecialCmd Pointer to the OPENBL_SpecialCmdTypeDef structure.
+  * @param  SendByte The function used to send one byte through the detected interface.
+  * @retval None.
+  */
+void OPENBL_POOL_StatsCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte)
+{
+  ErrorStatus status = (SpecialCmd->SizeBuffer1 == 0U) ? SUCCESS : ERROR;
+
+  if (SpecialCmd->CmdType == OPENBL_SPECIAL_CMD)
+  {
+    if (status == SUCCESS)
+    {
+      Common_SendHalfWord(SendByte, POOL_STATS_SIZE);
+      Common_SendHalfWord(SendByte, (uint16_t)POOL_BLOCK_SIZE);
+      SendByte((uint8_t)POOL_BLOCK_NUMBER);
+      SendByte((uint8_t)PoolUsedNumber);
+      SendByte((uint8_t)PoolHighWater);
+      Common_SendHalfWord(SendByte, (uint16_t)PoolFailedNumber);
+    }
+    else
+    {
+      /* Send NULL data size */
+      Common_SendHalfWord(SendByte, 0U);
+    }
+  }
+
+  Common_SendSpecialCmdStatus(SendByte, status);
+}
@@ -0,0 +1,46 @@
+/**
+  ******************************************************************************
+  * @file    pool_interface.h
+  * @author  MCD Application Team
+  * @brief   Header for pool_interface.c module
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef POOL_INTERFACE_H
+#define POOL_INTERFACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "openbl_core.h"
+#include "common_interface.h"
+
+/* Exported types ------------------------------------------------------------*/
+/* Exported constants --------------------------------------------------------*/
+#define POOL_BLOCK_SIZE                   (2U * 1024U)  /* Size of a block, one FLASH page */
+#define POOL_BLOCK_NUMBER                 2U            /* Number of blocks in SRAM2 */
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+uint8_t *OPENBL_POOL_Get(void);
+void OPENBL_POOL_Release(uint8_t *pBlock);
+void OPENBL_POOL_StatsCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POOL_INTERFACE_H */
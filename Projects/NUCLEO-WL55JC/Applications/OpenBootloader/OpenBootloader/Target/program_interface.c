@@ -0,0 +1,216 @@
+/**
+  ******************************************************************************
+  * @file    program_interface.c
+  * @author  MCD Application Team
+  * @brief   Contains the interrupt driven FLASH programming engine
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "platform.h"
+#include "common_interface.h"
+#include "iwdg_interface.h"
+#include "program_interface.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Double word waiting to be programmed */
+typedef struct
+{
+  uint32_t Address;
+  uint32_t Data[2];
+} PROG_RequestTypeDef;
+
+/* Private define ------------------------------------------------------------*/
+#define PROG_QUEUE_SIZE                   32U  /* Double words of one Write command of 256 bytes */
+#define PROG_SR_ERRORS                    (FLASH_SR_OPERR | FLASH_SR_PROGERR | FLASH_SR_WRPERR | FLASH_SR_PGAERR \
+                                           | FLASH_SR_SIZERR | FLASH_SR_PGSERR | FLASH_SR_MISERR | FLASH_SR_FASTERR)
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* The double word at the head of the queue is the one being programmed */
+static PROG_RequestTypeDef ProgQueue[PROG_QUEUE_SIZE];
+static volatile uint32_t ProgQueueHead  = 0U;
+static volatile uint32_t ProgQueueCount = 0U;
+static volatile uint32_t ProgErrors     = 0U;
+
+/* Private function prototypes -----------------------------------------------*/
+#if defined (__ICCARM__)
+__ramfunc static void OPENBL_PROG_StartNext(void);
+#else
+__attribute__((section(".ramfunc"))) static void OPENBL_PROG_StartNext(void);
+#endif /* (__ICCARM__) */
+
+/* Exported variables --------------------------------------------------------*/
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Configure the FLASH interrupt used by the programming engine and the background erase.
+  * @retval None.
+  */
+void OPENBL_PROG_Init(void)
+{
+  HAL_NVIC_SetPriority(FLASH_IRQn, 1U, 0U);
+  HAL_NVIC_EnableIRQ(FLASH_IRQn);
+}
+
+/**
+  * @brief  Queue a double word to be programmed by the FLASH interrupt.
+  * @note   The FLASH must be unlocked and no erase operation must be ongoing until the queue is empty.
+  *         This function only waits when the queue is full.
+  * @param  Address The address to be programmed, aligned on a double word.
+  * @param  Data The double word to be programmed.
+  * @retval None.
+  */
+void OPENBL_PROG_Submit(uint32_t Address, uint64_t Data)
+{
+  uint32_t index;
+  uint32_t primask;
+
+  /* Wait for a free entry, the queue is emptied by the FLASH interrupt */
+  while (ProgQueueCount >= PROG_QUEUE_SIZE)
+  {
+    OPENBL_IWDG_Refresh();
+  }
+
+  index = (ProgQueueHead + ProgQueueCount) % PROG_QUEUE_SIZE;
+
+  ProgQueue[index].Address = Address;
+  ProgQueue[index].Data[0] = (uint32_t)Data;
+  ProgQueue[index].Data[1] = (uint32_t)(Data >> 32U);
+
+  primask = Common_SaveDisableIrq();
+
+  ProgQueueCount++;
+
+  /* Start the programming if the engine is idle, otherwise the FLASH interrupt chains it */
+  if (ProgQueueCount == 1U)
+  {
+    OPENBL_PROG_StartNext();
+  }
+
+  Common_RestoreIrq(primask);
+}
+
+/**
+  * @brief  Wait until all the queued double words are programmed.
+  * @retval An ErrorStatus enumeration value:
+  *          - SUCCESS: All the double words queued since the previous call are programmed
+  *          - ERROR:   At least one double word failed to be programmed
+  */
+ErrorStatus OPENBL_PROG_WaitForCompletion(void)
+{
+  ErrorStatus status = SUCCESS;
+
+  while (ProgQueueCount != 0U)
+  {
+    OPENBL_IWDG_Refresh();
+  }
+
+  if (ProgErrors != 0U)
+  {
+    ProgErrors = 0U;
+    status     = ERROR;
+  }
+
+  return status;
+}
+
+/**
+  * @brief  Check if double words are waiting to be programmed.
+  * @retval 1 if the engine is programming, 0 if it is idle.
+  */
+uint32_t OPENBL_PROG_IsBusy(void)
+{
+  return ((ProgQueueCount != 0U) ? 1U : 0U);
+}
+
+/**
+  * @brief  Handle the end of a double word programming, then start the next one.
+  * @note   Executed from SRAM so that the next double word is started without any FLASH access.
+  * @retval An ErrorStatus enumeration value:
+  *          - SUCCESS: The interrupt is handled
+  *          - ERROR:   The interrupt is not caused by the programming engine
+  */
+#if defined (__ICCARM__)
+__ramfunc ErrorStatus OPENBL_PROG_IRQHandler(void)
+#else
+__attribute__((section(".ramfunc"))) ErrorStatus OPENBL_PROG_IRQHandler(void)
+#endif /* (__ICCARM__) */
+{
+  uint32_t flags     = FLASH->SR & (FLASH_SR_EOP | PROG_SR_ERRORS);
+  ErrorStatus status = ERROR;
+
+  if ((ProgQueueCount != 0U) && (flags != 0U))
+  {
+    CLEAR_BIT(FLASH->CR, (FLASH_CR_PG | FLASH_CR_EOPIE | FLASH_CR_ERRIE));
+
+    /* Clear the end of operation and error flags */
+    WRITE_REG(FLASH->SR, flags);
+
+    if ((flags & PROG_SR_ERRORS) != 0U)
+    {
+      ProgErrors++;
+    }
+
+    ProgQueueHead = (ProgQueueHead + 1U) % PROG_QUEUE_SIZE;
+    ProgQueueCount--;
+
+    OPENBL_PROG_StartNext();
+
+    status = SUCCESS;
+  }
+
+  return status;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Start the programming of the double word at the head of the queue.
+  * @note   A double word that can not be started because the FLASH is locked is dropped as an error.
+  * @retval None.
+  */
+#if defined (__ICCARM__)
+__ramfunc static void OPENBL_PROG_StartNext(void)
+#else
+__attribute__((section(".ramfunc"))) static void OPENBL_PROG_StartNext(void)
+#endif /* (__ICCARM__) */
+{
+  PROG_RequestTypeDef *p_request;
+
+  while ((ProgQueueCount != 0U) && (READ_BIT(FLASH->CR, FLASH_CR_LOCK) != 0U))
+  {
+    ProgErrors++;
+
+    ProgQueueHead = (ProgQueueHead + 1U) % PROG_QUEUE_SIZE;
+    ProgQueueCount--;
+  }
+
+  if (ProgQueueCount != 0U)
+  {
+    p_request = &ProgQueue[ProgQueueHead];
+
+    /* Clear all FLASH errors flags before starting write operation */
+    WRITE_REG(FLASH->SR, (FLASH_SR_EOP | PROG_SR_ERRORS));
+
+    /* The end of operation and the errors are reported by the FLASH interrupt */
+    SET_BIT(FLASH->CR, (FLASH_CR_PG | FLASH_CR_EOPIE | FLASH_CR_ERRIE));
+
+    *(__IO uint32_t *)(p_request->Address) = p_request->Data[0];
+
+    /* Barrier to ensure programming is performed in 2 steps, in right order */
+    __ISB();
+
+    *(__IO uint32_t *)(p_request->Address + 4U) = p_request->Data[1];
+  }
+}
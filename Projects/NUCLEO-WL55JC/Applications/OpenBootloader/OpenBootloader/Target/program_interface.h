@@ -0,0 +1,48 @@
+/**
+  ******************************************************************************
+  * @file    program_interface.h
+  * @author  MCD Application Team
+  * @brief   Header for program_interface.c module
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef PROGRAM_INTERFACE_H
+#define PROGRAM_INTERFACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "platform.h"
+
+/* Exported types ------------------------------------------------------------*/
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+void OPENBL_PROG_Init(void);
+void OPENBL_PROG_Submit(uint32_t Address, uint64_t Data);
+ErrorStatus OPENBL_PROG_WaitForCompletion(void);
+uint32_t OPENBL_PROG_IsBusy(void);
+#if defined (__ICCARM__)
+__ramfunc ErrorStatus OPENBL_PROG_IRQHandler(void);
+#else
+__attribute__((section(".ramfunc"))) ErrorStatus OPENBL_PROG_IRQHandler(void);
+#endif /* (__ICCARM__) */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROGRAM_INTERFACE_H */
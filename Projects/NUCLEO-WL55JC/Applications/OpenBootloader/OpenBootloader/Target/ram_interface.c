@@ -22,6 +22,9 @@
 #include "app_openbootloader.h"
 #include "common_interface.h"
 #include "ram_interface.h"
+#include "flash_interface.h"
+#include "iwdg_interface.h"
+#include "signature_interface.h"
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
@@ -29,9 +32,9 @@
 /* Private variables ---------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
 /* Exported variables --------------------------------------------------------*/
-OPENBL_MemoryTypeDef RAM_Descriptor =
+const OPENBL_MemoryTypeDef RAM_Descriptor =
 {
-  RAM_START_ADDRESS + OPENBL_RAM_SIZE, /* OPENBL_RAM_SIZE is added to the RAM start address to protect OpenBootloader RAM area */
+  RAM_USER_START_ADDRESS, /* The OpenBootloader RAM area and the compressed write window are protected */
   RAM_END_ADDRESS,
   RAM_SIZE,
   RAM_AREA,
@@ -58,6 +61,8 @@ uint8_t OPENBL_RAM_Read(uint32_t Address)
 
 /**
   * @brief  This function is used to write data in RAM memory.
+  * @note   Any length and any alignment are supported: the bytes up to the first word boundary of the
+  *         destination are copied one by one, then the data is copied by words.
   * @param  Address The address where that data will be written.
   * @param  pData The data to be written.
   * @param  DataLength The length of the data to be written.
@@ -65,22 +70,87 @@ uint8_t OPENBL_RAM_Read(uint32_t Address)
   */
 void OPENBL_RAM_Write(uint32_t Address, uint8_t *pData, uint32_t DataLength)
 {
-  uint32_t index;
-  uint32_t aligned_length = DataLength;
+  uint32_t word0;
+  uint32_t word1;
+  uint32_t word2;
+  uint32_t word3;
+  uint32_t *p_destination;
+  const uint32_t *p_source;
 
-  if (aligned_length & 0x3)
+  /* Bytes up to the first word boundary of the destination */
+  while (((Address & 0x3U) != 0U) && (DataLength > 0U))
   {
-    aligned_length = (aligned_length & 0xFCU) + 4U;
+    *(uint8_t *)Address = *pData;
+
+    Address++;
+    pData++;
+    DataLength--;
+  }
+
+  /* Word copy when the source is aligned too, four words per iteration so that the compiler can
+     use multiple load and store instructions */
+  if (((uint32_t)pData & 0x3U) == 0U)
+  {
+    p_destination = (uint32_t *)Address;
+    p_source      = (const uint32_t *)(uint32_t)pData;
+
+    while (DataLength >= 16U)
+    {
+      word0 = p_source[0];
+      word1 = p_source[1];
+      word2 = p_source[2];
+      word3 = p_source[3];
+
+      p_destination[0] = word0;
+      p_destination[1] = word1;
+      p_destination[2] = word2;
+      p_destination[3] = word3;
+
+      p_destination += 4U;
+      p_source      += 4U;
+      DataLength    -= 16U;
+    }
+
+    while (DataLength >= 4U)
+    {
+      *p_destination = *p_source;
+
+      p_destination++;
+      p_source++;
+      DataLength -= 4U;
+    }
+
+    Address = (uint32_t)p_destination;
+    pData   = (uint8_t *)(uint32_t)p_source;
+  }
+  else
+  {
+    /* The Cortex-M4 word loads accept an unaligned address */
+    while (DataLength >= 4U)
+    {
+      *(uint32_t *)Address = __UNALIGNED_UINT32_READ(pData);
+
+      Address    += 4U;
+      pData      += 4U;
+      DataLength -= 4U;
+    }
   }
 
-  for (index = 0U; index < aligned_length; index += 4U)
+  /* Bytes after the last word boundary */
+  while (DataLength > 0U)
   {
-    *(__IO uint32_t *)(Address + index) = *(__IO uint32_t *)(pData + index);
+    *(uint8_t *)Address = *pData;
+
+    Address++;
+    pData++;
+    DataLength--;
   }
 }
 
 /**
   * @brief  This function is used to jump to a given address.
+  * @note   Once a public key is programmed, the jump is refused and a NACK is sent after the ACK of
+  *         the Go command, the code written in RAM is not signed.
   * @param  Address The address where the function will jump.
   * @retval None.
   */
@@ -88,16 +158,74 @@ void OPENBL_RAM_JumpToAddress(uint32_t Address)
 {
   Function_Pointer jump_to_address;
 
-  /* De-initialize all HW resources used by the Open Bootloader to their reset values */
-  OPENBL_DeInit();
+  /* Program the data still cached by the FLASH interface */
+  OPENBL_FLASH_FlushWriteCache();
+
+  if (OPENBL_SIGN_IsKeyProgrammed() == 0U)
+  {
+    /* De-initialize all HW resources used by the Open Bootloader to their reset values */
+    OPENBL_DeInit();
+
+    /* Enable IRQ */
+    Common_EnableIrq();
+
+    jump_to_address = (Function_Pointer)(*(__IO uint32_t *)(Address + 4U));
+
+    /* Initialize user application's stack pointer */
+    Common_SetMsp(*(__IO uint32_t *) Address);
+
+    jump_to_address();
+  }
+  else
+  {
+    Common_SendNack();
+  }
+}
+
+/**
+  * @brief  This function is used to process the RAM loader extended special command.
+  *         Buffer1 contains the entry point of a RAM loader previously written in RAM by the Write
+  *         command, 4 bytes MSB first, with the Thumb bit set. Buffer2 contains the data given to
+  *         the loader. The loader is called as a function with the RAM_LoaderApiTypeDef services,
+  *         and the Open Bootloader keeps running when it returns. The status is the one returned by
+  *         the loader, or NACK if the entry point is not valid, if the read protection is active or
+  *         if a public key is programmed, the loader code is not signed.
+  * @param  SpecialCmd Pointer to the OPENBL_SpecialCmdTypeDef structure.
+  * @param  SendByte The function used to send one byte through the detected interface.
+  * @retval None.
+  */
+void OPENBL_RAM_LoaderCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte)
+{
+  uint32_t address;
+  RAM_LoaderApiTypeDef api;
+  RAM_LoaderEntryTypeDef loader;
+  ErrorStatus status = ERROR;
+
+  if ((SpecialCmd->SizeBuffer1 == 4U) && (Common_GetProtectionStatus() == RESET)
+      && (OPENBL_SIGN_IsKeyProgrammed() == 0U))
+  {
+    address = Common_GetWord(&SpecialCmd->Buffer1[0]);
 
-  /* Enable IRQ */
-  Common_EnableIrq();
+    /* The loader must not overwrite the RAM of the Open Bootloader */
+    if (((address & 0x1U) != 0U) && (address >= RAM_LOADER_START_ADDRESS) && (address < RAM_LOADER_END_ADDRESS))
+    {
+      api.Version             = RAM_LOADER_API_VERSION;
+      api.pData               = SpecialCmd->Buffer2;
+      api.DataLength          = SpecialCmd->SizeBuffer2;
+      api.FlashRead           = OPENBL_FLASH_Read;
+      api.FlashWrite          = OPENBL_FLASH_Write;
+      api.FlashFlush          = OPENBL_FLASH_FlushWriteCache;
+      api.GetFlashWriteStatus = OPENBL_FLASH_GetWriteStatus;
+      api.WatchdogRefresh     = OPENBL_IWDG_Refresh;
 
-  jump_to_address = (Function_Pointer)(*(__IO uint32_t *)(Address + 4U));
+      /* The loader code was written by data accesses */
+      __DSB();
+      __ISB();
 
-  /* Initialize user application's stack pointer */
-  Common_SetMsp(*(__IO uint32_t *) Address);
+      loader = (RAM_LoaderEntryTypeDef)address;
+      status = loader(&api);
+    }
+  }
 
-  jump_to_address();
+  Common_SendSpecialCmdStatus(SendByte, status);
 }
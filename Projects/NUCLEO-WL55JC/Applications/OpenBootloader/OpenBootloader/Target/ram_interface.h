@@ -25,13 +25,36 @@ extern "C" {
 #endif
 
 /* Includes ------------------------------------------------------------------*/
+#include "openbl_core.h"
+#include "common_interface.h"
+
 /* Exported types ------------------------------------------------------------*/
+/* Services given by the Open Bootloader to a RAM loader */
+typedef struct
+{
+  uint32_t Version;                                                      /* RAM_LOADER_API_VERSION */
+  uint8_t *pData;                                                        /* Data sent with the command */
+  uint32_t DataLength;                                                   /* Number of bytes of pData */
+  uint8_t (*FlashRead)(uint32_t Address);                                /* OPENBL_FLASH_Read() */
+  void (*FlashWrite)(uint32_t Address, uint8_t *pData, uint32_t DataLength); /* OPENBL_FLASH_Write() */
+  void (*FlashFlush)(void);                                              /* OPENBL_FLASH_FlushWriteCache() */
+  ErrorStatus (*GetFlashWriteStatus)(void);                              /* OPENBL_FLASH_GetWriteStatus() */
+  void (*WatchdogRefresh)(void);                                         /* OPENBL_IWDG_Refresh() */
+} RAM_LoaderApiTypeDef;
+
+/* Entry point of a RAM loader, called in thread mode with the interrupts enabled. The returned
+   status is sent to the host */
+typedef ErrorStatus (*RAM_LoaderEntryTypeDef)(const RAM_LoaderApiTypeDef *pApi);
+
 /* Exported constants --------------------------------------------------------*/
+#define RAM_LOADER_API_VERSION            0x0100U  /* Major version in the MSB, minor version in the LSB */
+
 /* Exported macro ------------------------------------------------------------*/
 /* Exported functions ------------------------------------------------------- */
 void OPENBL_RAM_JumpToAddress(uint32_t Address);
 uint8_t OPENBL_RAM_Read(uint32_t Address);
 void OPENBL_RAM_Write(uint32_t Address, uint8_t *Data, uint32_t DataLength);
+void OPENBL_RAM_LoaderCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,249 @@
+/**
+  ******************************************************************************
+  * @file    segment_interface.c
+  * @author  MCD Application Team
+  * @brief   Contains the functions of the segment list write
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "platform.h"
+#include "openbl_core.h"
+#include "app_openbootloader.h"
+#include "common_interface.h"
+#include "segment_interface.h"
+#include "flash_interface.h"
+#include "pool_interface.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* State of the segment list, kept between two segment write commands */
+typedef struct
+{
+  const OPENBL_MemoryTypeDef *pMemory;  /* Memory of the current segment */
+  uint8_t *pBuffer;                 /* Write buffer, borrowed from the pool while the list is started */
+  uint32_t Address;                 /* Address of the first byte of the write buffer */
+  uint32_t Remaining;               /* Number of bytes of the current segment not received yet */
+  uint32_t HeaderCount;             /* Number of bytes of the next segment header received */
+  uint32_t WriteCount;              /* Number of bytes in the write buffer */
+  uint8_t  Header[8];               /* Bytes of the next segment header */
+  uint8_t  Started;                 /* A segment list is started and no error occurred */
+} SEG_StreamTypeDef;
+
+/* Private define ------------------------------------------------------------*/
+#define SEG_CMD_START                     0x00U  /* Start a segment list */
+#define SEG_CMD_CONTINUE                  0x01U  /* Process the next bytes of the segment list */
+#define SEG_CMD_END                       0x02U  /* End the segment list and program its last bytes */
+
+#define SEG_HEADER_SIZE                   8U     /* Address and length of a segment, 4 bytes each */
+#define SEG_WRITE_SIZE                    POOL_BLOCK_SIZE  /* Segment bytes given at once to the memory interface */
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static SEG_StreamTypeDef SegStream = {0U};
+
+/* Private function prototypes -----------------------------------------------*/
+static ErrorStatus OPENBL_SEG_Parse(uint8_t *pData, uint32_t Length);
+static ErrorStatus OPENBL_SEG_StartSegment(void);
+static void OPENBL_SEG_WriteBuffer(void);
+
+/* Exported variables --------------------------------------------------------*/
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  This function is used to process the segment write extended special command.
+  *         Buffer1 is 0x00 to start a segment list, 0x01 to continue it or 0x02 to end it. Buffer2
+  *         contains the next bytes of the list: each segment is its address and its length, 4 bytes
+  *         each MSB first, followed by its data. The list can be split at any byte between two
+  *         commands. Each segment is written in the memory that contains it, as by the Write command.
+  *         The status is NACK if a segment is not fully inside one writable memory, and at the end
+  *         of the list if a FLASH programming error occurred.
+  * @param  SpecialCmd Pointer to the OPENBL_SpecialCmdTypeDef structure.
+  * @param  SendByte The function used to send one byte through the detected interface.
+  * @retval None.
+  */
+void OPENBL_SEG_WriteCommand(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte)
+{
+  ErrorStatus status = ERROR;
+
+  if ((Common_GetProtectionStatus() != RESET) || (SpecialCmd->SizeBuffer1 != 1U))
+  {
+    SegStream.Started = 0U;
+  }
+  else if (SpecialCmd->Buffer1[0] == SEG_CMD_START)
+  {
+    /* The buffer of a list that was not ended is reused */
+    if (SegStream.pBuffer == NULL)
+    {
+      SegStream.pBuffer = OPENBL_POOL_Get();
+    }
+
+    SegStream.pMemory     = NULL;
+    SegStream.Remaining   = 0U;
+    SegStream.HeaderCount = 0U;
+    SegStream.WriteCount  = 0U;
+    SegStream.Started     = (SegStream.pBuffer != NULL) ? 1U : 0U;
+
+    status = (SegStream.pBuffer != NULL) ? SUCCESS : ERROR;
+  }
+  else if (SpecialCmd->Buffer1[0] == SEG_CMD_CONTINUE)
+  {
+    status = (SegStream.Started != 0U) ? SUCCESS : ERROR;
+  }
+  else if (SpecialCmd->Buffer1[0] == SEG_CMD_END)
+  {
+    status = (SegStream.Started != 0U) ? SUCCESS : ERROR;
+
+    SegStream.Started = 0U;
+  }
+  else
+  {
+    /* Unknown operation */
+  }
+
+  if ((status == SUCCESS) && (SpecialCmd->SizeBuffer2 != 0U))
+  {
+    status = OPENBL_SEG_Parse(SpecialCmd->Buffer2, SpecialCmd->SizeBuffer2);
+  }
+
+  if ((status == SUCCESS) && (SpecialCmd->Buffer1[0] == SEG_CMD_END))
+  {
+    /* A list can not end in the middle of a segment */
+    if ((SegStream.HeaderCount != 0U) || (SegStream.Remaining != 0U))
+    {
+      status = ERROR;
+    }
+    else
+    {
+      OPENBL_FLASH_FlushWriteCache();
+
+      status = OPENBL_FLASH_GetWriteStatus();
+    }
+  }
+
+  if (status != SUCCESS)
+  {
+    /* The next bytes of a broken list can not be located */
+    SegStream.Started = 0U;
+  }
+
+  if (SegStream.Started == 0U)
+  {
+    OPENBL_POOL_Release(SegStream.pBuffer);
+    SegStream.pBuffer = NULL;
+  }
+
+  Common_SendSpecialCmdStatus(SendByte, status);
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Process the next bytes of the segment list.
+  * @param  pData Pointer to the bytes.
+  * @param  Length The number of bytes.
+  * @retval An ErrorStatus enumeration value:
+  *          - SUCCESS: The bytes are processed
+  *          - ERROR:   A segment is not fully inside one writable memory
+  */
+static ErrorStatus OPENBL_SEG_Parse(uint8_t *pData, uint32_t Length)
+{
+  uint32_t index = 0U;
+  uint32_t count;
+  ErrorStatus status = SUCCESS;
+
+  while ((index < Length) && (status == SUCCESS))
+  {
+    if (SegStream.Remaining == 0U)
+    {
+      SegStream.Header[SegStream.HeaderCount] = pData[index];
+      SegStream.HeaderCount++;
+      index++;
+
+      if (SegStream.HeaderCount == SEG_HEADER_SIZE)
+      {
+        SegStream.HeaderCount = 0U;
+
+        status = OPENBL_SEG_StartSegment();
+      }
+    }
+    else
+    {
+      /* Copy as many data bytes as possible at once */
+      count = SEG_WRITE_SIZE - SegStream.WriteCount;
+
+      if (count > SegStream.Remaining)
+      {
+        count = SegStream.Remaining;
+      }
+
+      if (count > (Length - index))
+      {
+        count = Length - index;
+      }
+
+      SegStream.Remaining -= count;
+
+      while (count > 0U)
+      {
+        SegStream.pBuffer[SegStream.WriteCount] = pData[index];
+        SegStream.WriteCount++;
+        index++;
+        count--;
+      }
+
+      if ((SegStream.WriteCount == SEG_WRITE_SIZE) || (SegStream.Remaining == 0U))
+      {
+        OPENBL_SEG_WriteBuffer();
+      }
+    }
+  }
+
+  return status;
+}
+
+/**
+  * @brief  Start the segment described by the received header.
+  * @note   The option bytes are refused since they are only loaded by a system reset, they are
+  *         written by the Write command.
+  * @retval An ErrorStatus enumeration value:
+  *          - SUCCESS: The segment is started
+  *          - ERROR:   The segment is not fully inside one writable memory
+  */
+static ErrorStatus OPENBL_SEG_StartSegment(void)
+{
+  ErrorStatus status = ERROR;
+
+  SegStream.Address   = Common_GetWord(&SegStream.Header[0]);
+  SegStream.Remaining = Common_GetWord(&SegStream.Header[4]);
+  SegStream.pMemory   = Common_GetMemory(SegStream.Address, SegStream.Remaining);
+
+  if ((SegStream.pMemory != NULL) && (SegStream.pMemory->Write != NULL) && (SegStream.pMemory->Type != OB_AREA))
+  {
+    status = SUCCESS;
+  }
+
+  return status;
+}
+
+/**
+  * @brief  Give the bytes of the write buffer to the interface of the segment memory.
+  * @note   The FLASH interface caches a partial double word until the next bytes are written.
+  * @retval None.
+  */
+static void OPENBL_SEG_WriteBuffer(void)
+{
+  SegStream.pMemory->Write(SegStream.Address, SegStream.pBuffer, SegStream.WriteCount);
+
+  SegStream.Address   += SegStream.WriteCount;
+  SegStream.WriteCount = 0U;
+}
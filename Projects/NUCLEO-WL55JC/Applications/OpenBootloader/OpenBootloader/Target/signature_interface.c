@@ -0,0 +1,362 @@
+/**
+  ******************************************************************************
+  * @file    signature_interface.c
+  * @author  MCD Application Team
+  * @brief   Contains image signature verification functions
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "platform.h"
+#include "openbl_core.h"
+#include "app_openbootloader.h"
+#include "common_interface.h"
+#include "signature_interface.h"
+#include "hash_interface.h"
+#include "flash_interface.h"
+#include "iwdg_interface.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Image whose signature is verified */
+typedef struct
+{
+  HASH_ContextTypeDef Context;  /* SHA-256 of the image bytes written so far */
+  uint32_t Address;             /* Start address of the image */
+  uint32_t Length;              /* Length of the image, 0 if no image is declared */
+  uint32_t NextAddress;         /* Address of the next image byte to be hashed */
+  uint32_t WriteErrors;         /* FLASH programming errors counted when the image was declared */
+  uint8_t  Streaming;           /* The image bytes are hashed as they are written, in order */
+  uint8_t  Verified;            /* The signature of the image is verified */
+} SIGN_ImageTypeDef;
+
+/* Private define ------------------------------------------------------------*/
+#define SIGN_CMD_START                    0x00U  /* Declare the image to be verified */
+#define SIGN_CMD_VERIFY                   0x01U  /* Verify the signature of the image */
+
+#define SIGN_ECC_SIZE                     32U    /* Size of the P-256 curve elements */
+#define SIGN_HASH_CHUNK_SIZE              (4U * 1024U)  /* Bytes hashed between two watchdog refreshes */
+#define SIGN_PKA_TIMEOUT                  1000U  /* Timeout of the PKA operation in ms */
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static SIGN_ImageTypeDef SignImage = {0U};
+
+/* NIST P-256 curve, most significant byte first */
+static const uint8_t SignCurveA[SIGN_ECC_SIZE] =  /* Absolute value of the a coefficient, -3 */
+{
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03
+};
+
+static const uint8_t SignCurveModulus[SIGN_ECC_SIZE] =
+{
+  0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+static const uint8_t SignCurveOrder[SIGN_ECC_SIZE] =
+{
+  0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xBC, 0xE6, 0xFA, 0xAD, 0xA7, 0x17, 0x9E, 0x84, 0xF3, 0xB9, 0xCA, 0xC2, 0xFC, 0x63, 0x25, 0x51
+};
+
+static const uint8_t SignCurveGx[SIGN_ECC_SIZE] =
+{
+  0x6B, 0x17, 0xD1, 0xF2, 0xE1, 0x2C, 0x42, 0x47, 0xF8, 0xBC, 0xE6, 0xE5, 0x63, 0xA4, 0x40, 0xF2,
+  0x77, 0x03, 0x7D, 0x81, 0x2D, 0xEB, 0x33, 0xA0, 0xF4, 0xA1, 0x39, 0x45, 0xD8, 0x98, 0xC2, 0x96
+};
+
+static const uint8_t SignCurveGy[SIGN_ECC_SIZE] =
+{
+  0x4F, 0xE3, 0x42, 0xE2, 0xFE, 0x1A, 0x7F, 0x9B, 0x8E, 0xE7, 0xEB, 0x4A, 0x7C, 0x0F, 0x9E, 0x16,
+  0x2B, 0xCE, 0x33, 0x57, 0x6B, 0x31, 0x5E, 0xCE, 0xCB, 0xB6, 0x40, 0x68, 0x37, 0xBF, 0x51, 0xF5
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static ErrorStatus OPENBL_SIGN_Verify(uint8_t *pSignature);
+static ErrorStatus OPENBL_SIGN_VerifyDigest(uint8_t *pDigest, uint8_t *pSignature);
+
+/* Exported variables --------------------------------------------------------*/
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Hash the image bytes written in FLASH.
+  * @note   Called by the FLASH write before programming, the bytes written in order from the image
+  *         start are hashed, so that the digest is known once the last byte is received. A write that
+  *         skips or rewrites image bytes stops the incremental hash, the image is then read back from
+  *         the FLASH by the verification.
+  * @param  Address The address where that data will be written.
+  * @param  pData The data to be written.
+  * @param  DataLength The length of the data to be written.
+  * @retval None.
+  */
+void OPENBL_SIGN_Update(uint32_t Address, uint8_t *pData, uint32_t DataLength)
+{
+  uint32_t start;
+  uint32_t end;
+  uint32_t image_end = SignImage.Address + SignImage.Length;
+
+  /* Only the writes overlapping the image are of interest */
+  if ((SignImage.Length != 0U) && (Address < image_end) && ((Address + DataLength) > SignImage.Address))
+  {
+    SignImage.Verified = 0U;
+
+    start = (Address > SignImage.Address) ? Address : SignImage.Address;
+    end   = ((Address + DataLength) < image_end) ? (Address + DataLength) : image_end;
+
+    if ((SignImage.Streaming != 0U) && (start == SignImage.NextAddress))
+    {
+      OPENBL_HASH_Update(&SignImage.Context, &pData[start - Address], end - start);
+
+      SignImage.NextAddress = end;
+    }
+    else
+    {
+      SignImage.Streaming = 0U;
+    }
+  }
+}
+
+/**
+  * @brief  Take into account the erase of a FLASH area.
+  * @note   The erase of image bytes already hashed stops the incremental hash, the erase of any image
+  *         byte cancels the verification.
+  * @param  Address The start address of the erased area.
+  * @param  Length The length of the erased area.
+  * @retval None.
+  */
+void OPENBL_SIGN_Invalidate(uint32_t Address, uint32_t Length)
+{
+  if ((SignImage.Length != 0U) && (Address < (SignImage.Address + SignImage.Length))
+      && ((Address + Length) > SignImage.Address))
+  {
+    SignImage.Verified = 0U;
+
+    if ((Address < SignImage.NextAddress) && (SignImage.NextAddress != SignImage.Address))
+    {
+      SignImage.Streaming = 0U;
+    }
+  }
+}
+
+/**
+  * @brief  Check if the application at a given address can be started.
+  * @note   Once a public key is programmed, only an image whose signature is verified can be started.
+  * @param  Address The address of the application.
+  * @retval An ErrorStatus enumeration value:
+  *          - SUCCESS: The application can be started
+  *          - ERROR:   The signature of the application is not verified
+  */
+ErrorStatus OPENBL_SIGN_IsJumpAllowed(uint32_t Address)
+{
+  ErrorStatus status = SUCCESS;
+
+  if ((OPENBL_SIGN_IsKeyProgrammed() != 0U)
+      && ((SignImage.Verified == 0U) || (Address != SignImage.Address)))
+  {
+    status = ERROR;
+  }
+
+  return status;
+}
+
+/**
+  * @brief  Check if the public key is programmed in OTP.
+  * @note   Once it is programmed, only the verified image is started, the code written in RAM is
+  *         never run.
+  * @retval 1 if the public key is programmed, 0 if its area is blank.
+  */
+uint32_t OPENBL_SIGN_IsKeyProgrammed(void)
+{
+  uint32_t index;
+  uint32_t programmed = 0U;
+
+  for (index = 0U; index < (SIGN_ECC_SIZE * 2U); index += 4U)
+  {
+    if (*(__IO uint32_t *)(SIGN_PUBLIC_KEY_ADDRESS + index) != 0xFFFFFFFFU)
+    {
+      programmed = 1U;
+    }
+  }
+
+  return programmed;
+}
+
+/**
+  * @brief  This function is used to process the signature special command.
+  *         Buffer1 is 0x00 followed by the image address and length (4 bytes each, MSB first) to declare
+  *         the image before it is written, or 0x01 followed by the ECDSA P-256 signature of the SHA-256
+  *         of the image, r then s (32 bytes each, MSB first), to verify it. The status is NACK if the
+  *         image is not valid, if no public key is programmed, if a FLASH programming error occurred
+  *         since the image was declared or if the signature does not match.
+  * @param  SpecialCmd Pointer to the OPENBL_SpecialCmdTypeDef structure.
+  * @param  SendByte The function used to send one byte through the detected interface.
+  * @retval None.
+  */
+void OPENBL_SIGN_Command(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte)
+{
+  uint32_t address;
+  uint32_t length;
+  ErrorStatus status = ERROR;
+
+  if ((SpecialCmd->SizeBuffer1 == 9U) && (SpecialCmd->Buffer1[0] == SIGN_CMD_START))
+  {
+    address = Common_GetWord(&SpecialCmd->Buffer1[1]);
+    length  = Common_GetWord(&SpecialCmd->Buffer1[5]);
+
+    if ((length != 0U) && (address >= FLASH_START_ADDRESS) && (address < FLASH_END_ADDRESS)
+        && (length <= (FLASH_END_ADDRESS - address)))
+    {
+      OPENBL_HASH_Init(&SignImage.Context);
+
+      SignImage.Address     = address;
+      SignImage.Length      = length;
+      SignImage.NextAddress = address;
+      SignImage.WriteErrors = OPENBL_FLASH_GetWriteErrorCount();
+      SignImage.Streaming   = 1U;
+      SignImage.Verified    = 0U;
+
+      status = SUCCESS;
+    }
+  }
+  else if ((SpecialCmd->SizeBuffer1 == ((SIGN_ECC_SIZE * 2U) + 1U)) && (SpecialCmd->Buffer1[0] == SIGN_CMD_VERIFY))
+  {
+    status = OPENBL_SIGN_Verify(&SpecialCmd->Buffer1[1]);
+  }
+  else
+  {
+    /* Unknown operation */
+  }
+
+  if (SpecialCmd->CmdType == OPENBL_SPECIAL_CMD)
+  {
+    /* Send NULL data size */
+    Common_SendHalfWord(SendByte, 0U);
+  }
+
+  Common_SendSpecialCmdStatus(SendByte, status);
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Verify the signature of the declared image.
+  * @note   The digest computed while the image was written is used when all the image bytes were
+  *         written in order, otherwise the image is hashed from the FLASH. The hashed bytes are the
+  *         FLASH content only if no programming error occurred since the image was declared, the
+  *         error count used here is not cleared by the flush or CRC commands.
+  * @param  pSignature Pointer to the signature, r then s.
+  * @retval An ErrorStatus enumeration value:
+  *          - SUCCESS: The signature is verified
+  *          - ERROR:   The signature does not match or the image is not programmed
+  */
+static ErrorStatus OPENBL_SIGN_Verify(uint8_t *pSignature)
+{
+  uint32_t address;
+  uint32_t length;
+  uint32_t chunk;
+  uint8_t digest[HASH_DIGEST_SIZE];
+  ErrorStatus status = ERROR;
+
+  if ((SignImage.Length != 0U) && (OPENBL_SIGN_IsKeyProgrammed() != 0U))
+  {
+    /* The image must be programmed without error */
+    OPENBL_FLASH_FlushWriteCache();
+    OPENBL_FLASH_WaitForPendingErase();
+
+    if (OPENBL_FLASH_GetWriteErrorCount() == SignImage.WriteErrors)
+    {
+      status = SUCCESS;
+    }
+  }
+
+  if (status == SUCCESS)
+  {
+    if ((SignImage.Streaming == 0U) || (SignImage.NextAddress != (SignImage.Address + SignImage.Length)))
+    {
+      OPENBL_HASH_Init(&SignImage.Context);
+
+      address = SignImage.Address;
+      length  = SignImage.Length;
+
+      while (length > 0U)
+      {
+        OPENBL_IWDG_Refresh();
+
+        chunk = (length > SIGN_HASH_CHUNK_SIZE) ? SIGN_HASH_CHUNK_SIZE : length;
+        OPENBL_HASH_Update(&SignImage.Context, (uint8_t *)address, chunk);
+
+        address += chunk;
+        length  -= chunk;
+      }
+    }
+
+    OPENBL_HASH_Final(&SignImage.Context, digest);
+
+    /* The context is consumed, a new verification reads the image back */
+    SignImage.Streaming = 0U;
+
+    status = OPENBL_SIGN_VerifyDigest(digest, pSignature);
+  }
+
+  SignImage.Verified = (status == SUCCESS) ? 1U : 0U;
+
+  return status;
+}
+
+/**
+  * @brief  Verify an ECDSA P-256 signature with the PKA peripheral.
+  * @note   The public key is programmed in OTP, X then Y (32 bytes each, MSB first).
+  * @param  pDigest Pointer to the SHA-256 digest of the image.
+  * @param  pSignature Pointer to the signature, r then s.
+  * @retval An ErrorStatus enumeration value:
+  *          - SUCCESS: The signature is valid
+  *          - ERROR:   The signature is not valid or the PKA operation failed
+  */
+static ErrorStatus OPENBL_SIGN_VerifyDigest(uint8_t *pDigest, uint8_t *pSignature)
+{
+  PKA_HandleTypeDef pka_handle = {0U};
+  PKA_ECDSAVerifInTypeDef verif_in;
+  ErrorStatus status = ERROR;
+
+  pka_handle.Instance = PKA;
+
+  if (HAL_PKA_Init(&pka_handle) == HAL_OK)
+  {
+    verif_in.primeOrderSize  = SIGN_ECC_SIZE;
+    verif_in.modulusSize     = SIGN_ECC_SIZE;
+    verif_in.coefSign        = 1U;
+    verif_in.coef            = SignCurveA;
+    verif_in.modulus         = SignCurveModulus;
+    verif_in.basePointX      = SignCurveGx;
+    verif_in.basePointY      = SignCurveGy;
+    verif_in.pPubKeyCurvePtX = (uint8_t *)SIGN_PUBLIC_KEY_ADDRESS;
+    verif_in.pPubKeyCurvePtY = (uint8_t *)(SIGN_PUBLIC_KEY_ADDRESS + SIGN_ECC_SIZE);
+    verif_in.RSign           = pSignature;
+    verif_in.SSign           = &pSignature[SIGN_ECC_SIZE];
+    verif_in.hash            = pDigest;
+    verif_in.primeOrder      = SignCurveOrder;
+
+    OPENBL_IWDG_Refresh();
+
+    if ((HAL_PKA_ECDSAVerif(&pka_handle, &verif_in, SIGN_PKA_TIMEOUT) == HAL_OK)
+        && (HAL_PKA_ECDSAVerif_IsValidSignature(&pka_handle) == 1U))
+    {
+      status = SUCCESS;
+    }
+
+    (void)HAL_PKA_DeInit(&pka_handle);
+  }
+
+  return status;
+}
@@ -0,0 +1,45 @@
+/**
+  ******************************************************************************
+  * @file    signature_interface.h
+  * @author  MCD Application Team
+  * @brief   Header for signature_interface.c module
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SIGNATURE_INTERFACE_H
+#define SIGNATURE_INTERFACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "openbl_core.h"
+#include "common_interface.h"
+
+/* Exported types ------------------------------------------------------------*/
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+void OPENBL_SIGN_Update(uint32_t Address, uint8_t *pData, uint32_t DataLength);
+void OPENBL_SIGN_Invalidate(uint32_t Address, uint32_t Length);
+ErrorStatus OPENBL_SIGN_IsJumpAllowed(uint32_t Address);
+uint32_t OPENBL_SIGN_IsKeyProgrammed(void);
+void OPENBL_SIGN_Command(OPENBL_SpecialCmdTypeDef *SpecialCmd, Send_Byte_Func *SendByte);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIGNATURE_INTERFACE_H */
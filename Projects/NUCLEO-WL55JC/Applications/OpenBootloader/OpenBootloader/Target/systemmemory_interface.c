@@ -29,7 +29,7 @@
 /* Private variables ---------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
 /* Exported variables --------------------------------------------------------*/
-OPENBL_MemoryTypeDef ICP1_Descriptor =
+const OPENBL_MemoryTypeDef ICP1_Descriptor =
 {
   ICP1_START_ADDRESS,
   ICP1_END_ADDRESS,
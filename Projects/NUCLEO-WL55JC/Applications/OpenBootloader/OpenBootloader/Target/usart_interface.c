@@ -23,6 +23,17 @@
 #include "usart_interface.h"
 #include "iwdg_interface.h"
 #include "interfaces_conf.h"
+#include "app_openbootloader.h"
+#include "flash_interface.h"
+#include "crc_interface.h"
+#include "lzss_interface.h"
+#include "cryp_interface.h"
+#include "signature_interface.h"
+#include "hash_interface.h"
+#include "segment_interface.h"
+#include "ram_interface.h"
+#include "pool_interface.h"
+#include "otp_interface.h"
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
@@ -65,6 +76,10 @@ static void OPENBL_USART_Init(void)
   }
 
   LL_USART_Init(USARTx, &USART_InitStruct);
+
+  /* The bytes of a command opcode received during a page erase wait in the FIFO, the CPU is stalled */
+  LL_USART_EnableFIFO(USARTx);
+
   LL_USART_Enable(USARTx);
 }
 
@@ -148,6 +163,15 @@ uint8_t OPENBL_USART_ProtocolDetection(void)
   return UsartDetected;
 }
 
+/**
+ * @brief  This function is used to know if the USART is the detected interface.
+ * @retval Returns 1 if interface is detected else 0.
+ */
+uint8_t OPENBL_USART_IsDetected(void)
+{
+  return UsartDetected;
+}
+
 /**
  * @brief  This function is used to get the command opcode from the host.
  * @retval Returns the command.
@@ -156,6 +180,9 @@ uint8_t OPENBL_USART_GetCommandOpcode(void)
 {
   uint8_t command_opc;
 
+  /* The queued pages are only erased while waiting for a command */
+  OPENBL_FLASH_ResumeErase();
+
   /* Get the command opcode */
   command_opc = OPENBL_USART_ReadByte();
 
@@ -165,6 +192,9 @@ uint8_t OPENBL_USART_GetCommandOpcode(void)
     command_opc = ERROR_COMMAND;
   }
 
+  /* No byte of the command must be received during a page erase */
+  OPENBL_FLASH_SuspendErase();
+
   return command_opc;
 }
 
@@ -206,6 +236,78 @@ void OPENBL_USART_SpecialCommandProcess(OPENBL_SpecialCmdTypeDef *SpecialCmd)
 {
   switch (SpecialCmd->OpCode)
   {
+    case SPECIAL_CMD_ERASE_ON_WRITE:
+      OPENBL_FLASH_EraseOnWriteCommand(SpecialCmd, OPENBL_USART_SendByte);
+      break;
+
+    case SPECIAL_CMD_PAGE_DIGEST:
+      OPENBL_FLASH_PageDigestCommand(SpecialCmd, OPENBL_USART_SendByte);
+      break;
+
+    case SPECIAL_CMD_CRC:
+      OPENBL_CRC_Command(SpecialCmd, OPENBL_USART_SendByte);
+      break;
+
+    case SPECIAL_CMD_FLASH_FLUSH:
+      OPENBL_FLASH_FlushCommand(SpecialCmd, OPENBL_USART_SendByte);
+      break;
+
+    case SPECIAL_CMD_ERASE_STATUS:
+      OPENBL_FLASH_EraseStatusCommand(SpecialCmd, OPENBL_USART_SendByte);
+      break;
+
+    case SPECIAL_CMD_RANGE_ERASE:
+      OPENBL_FLASH_RangeEraseCommand(SpecialCmd, OPENBL_USART_SendByte);
+      break;
+
+    case SPECIAL_CMD_SLOT:
+      OPENBL_FLASH_SlotCommand(SpecialCmd, OPENBL_USART_SendByte);
+      break;
+
+    case SPECIAL_CMD_JOURNAL:
+      OPENBL_FLASH_JournalCommand(SpecialCmd, OPENBL_USART_SendByte);
+      break;
+
+    case SPECIAL_CMD_WEAR:
+      OPENBL_FLASH_WearCommand(SpecialCmd, OPENBL_USART_SendByte);
+      break;
+
+    case SPECIAL_CMD_ECC_SCAN:
+      OPENBL_FLASH_EccScanCommand(SpecialCmd, OPENBL_USART_SendByte);
+      break;
+
+    case SPECIAL_CMD_SIGNATURE:
+      OPENBL_SIGN_Command(SpecialCmd, OPENBL_USART_SendByte);
+      break;
+
+    case SPECIAL_CMD_DIGEST:
+      OPENBL_HASH_Command(SpecialCmd, OPENBL_USART_SendByte);
+      break;
+
+    case SPECIAL_CMD_POOL_STATS:
+      OPENBL_POOL_StatsCommand(SpecialCmd, OPENBL_USART_SendByte);
+      break;
+
+    case SPECIAL_CMD_OTP_STATUS:
+      OPENBL_OTP_StatusCommand(SpecialCmd, OPENBL_USART_SendByte);
+      break;
+
+    case SPECIAL_CMD_COMPRESSED_WRITE:
+      OPENBL_LZSS_WriteCommand(SpecialCmd, OPENBL_USART_SendByte);
+      break;
+
+    case SPECIAL_CMD_ENCRYPTED_WRITE:
+      OPENBL_CRYP_WriteCommand(SpecialCmd, OPENBL_USART_SendByte);
+      break;
+
+    case SPECIAL_CMD_SEGMENT_WRITE:
+      OPENBL_SEG_WriteCommand(SpecialCmd, OPENBL_USART_SendByte);
+      break;
+
+    case SPECIAL_CMD_RAM_LOADER:
+      OPENBL_RAM_LoaderCommand(SpecialCmd, OPENBL_USART_SendByte);
+      break;
+
     /* Unknown command opcode */
     default:
       if (SpecialCmd->CmdType == OPENBL_SPECIAL_CMD)
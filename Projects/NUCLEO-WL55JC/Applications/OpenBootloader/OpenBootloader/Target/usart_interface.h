@@ -35,6 +35,7 @@ extern "C" {
 void OPENBL_USART_Configuration(void);
 void OPENBL_USART_DeInit(void);
 uint8_t OPENBL_USART_ProtocolDetection(void);
+uint8_t OPENBL_USART_IsDetected(void);
 uint8_t OPENBL_USART_GetCommandOpcode(void);
 uint8_t OPENBL_USART_ReadByte(void);
 void OPENBL_USART_SendByte(uint8_t Byte);